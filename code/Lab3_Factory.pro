@@ -2,7 +2,7 @@ QT       += core gui widgets
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++17
+CONFIG += c++2a
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -10,24 +10,59 @@ CONFIG += c++17
 
 LIBS += -lpcosynchro
 
+# Uncomment to measure lock waits, lock holds and trade latencies
+# (see instrumentation.h and the metrics.file scenario key)
+#DEFINES += PCO_INSTRUMENTATION
+
 SOURCES += \
+    checkpoint.cpp \
+    consolemodel.cpp \
     display.cpp \
+    eventlog.cpp \
     extractor.cpp \
     factory.cpp \
+    fundauditor.cpp \
+    instrumentation.cpp \
+    journal.cpp \
     main.cpp \
     mainwindow.cpp \
+    rng.cpp \
+    scenario.cpp \
+    topology.cpp \
+    tradeflows.cpp \
+    updatechannel.cpp \
+    scheduler.cpp \
     seller.cpp \
+    simclock.cpp \
+    simulationsink.cpp \
     utils.cpp \
     wholesale.cpp \
     windowinterface.cpp
 
 HEADERS += \
+    checkpoint.h \
+    consolemodel.h \
     costs.h \
     display.h \
+    eventlog.h \
     extractor.h \
     factory.h \
+    fundauditor.h \
+    instrumentation.h \
+    journal.h \
     mainwindow.h \
+    rng.h \
+    routine.h \
+    scenario.h \
+    scheduler.h \
     seller.h \
+    simclock.h \
+    simulationsink.h \
+    topology.h \
+    tradeflows.h \
+    updatechannel.h \
+    seqlock.h \
+    stockledger.h \
     utils.h \
     wholesale.h \
     windowinterface.h
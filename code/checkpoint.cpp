@@ -0,0 +1,220 @@
+/**
+ * @file checkpoint.cpp
+ * @brief Implementation of the simulation checkpoints
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "checkpoint.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'P', 'C', 'O', 'C', 'K', 'P', 'T', '\0'};
+
+/**
+ * @brief Vérifie le type et l'objet de chaque vendeur, qui suivent l'en-tête :
+ *        mines (matière première), grossistes (aucun objet) puis usines
+ *        (produit)
+ */
+bool validSellers(const CheckpointHeader& header) {
+    const auto* sellers = reinterpret_cast<const SellerState*>(&header + 1);
+    std::size_t nbWholesalersEnd = std::size_t(header.nbExtractors) + header.nbWholesalers;
+    std::size_t nbSellers = nbWholesalersEnd + header.nbFactories;
+    for (std::size_t i = 0; i < nbSellers; ++i) {
+        const SellerState& state = sellers[i];
+        auto item = static_cast<ItemType>(state.item);
+        bool valid;
+        if (i < header.nbExtractors) {
+            valid = state.kind == SellerKind::Extractor &&
+                    (item == ItemType::Sand || item == ItemType::Copper || item == ItemType::Petrol);
+        } else if (i < nbWholesalersEnd) {
+            valid = state.kind == SellerKind::Wholesaler && item == ItemType::Nothing;
+        } else {
+            valid = state.kind == SellerKind::Factory &&
+                    (item == ItemType::Chip || item == ItemType::Plastic || item == ItemType::Robot);
+        }
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::atomic<bool> Checkpoint::armed{false};
+std::atomic<bool> Checkpoint::closed{false};
+std::atomic<unsigned> Checkpoint::activeTrades{0};
+std::mutex Checkpoint::quiesceMutex;
+std::function<void()> Checkpoint::take;
+std::mutex Checkpoint::runMutex;
+std::condition_variable Checkpoint::wakeUp;
+bool Checkpoint::stopping = false;
+std::thread Checkpoint::writer;
+
+CheckpointImage::~CheckpointImage() {
+    if (data) {
+        ::munmap(data, size);
+    }
+}
+
+bool CheckpointImage::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open checkpoint " + path;
+        return false;
+    }
+
+    struct stat info {};
+    std::size_t length = ::fstat(fd, &info) == 0 ? static_cast<std::size_t>(info.st_size) : 0;
+    void* mapped = length >= sizeof(CheckpointHeader)
+                       ? ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0)
+                       : MAP_FAILED;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "cannot read checkpoint " + path;
+        return false;
+    }
+
+    const auto* candidate = static_cast<const CheckpointHeader*>(mapped);
+    // Chaque nombre est élargi avant l'addition : leur somme sur 32 bits
+    // pourrait déborder et accepter un fichier trop court
+    std::size_t expected = sizeof(CheckpointHeader) +
+                           (std::size_t(candidate->nbExtractors) + candidate->nbWholesalers +
+                            candidate->nbFactories) * sizeof(SellerState) +
+                           std::size_t(candidate->nbLinks) * sizeof(LinkState);
+    if (std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + " is not a checkpoint";
+    } else if (candidate->version != Checkpoint::VERSION ||
+               candidate->headerSize != sizeof(CheckpointHeader) ||
+               candidate->sellerSize != sizeof(SellerState) ||
+               candidate->linkSize != sizeof(LinkState)) {
+        error = path + " was written by an incompatible version";
+    } else if (length != expected || candidate->nbSupplyLinks > candidate->nbLinks ||
+               !validSellers(*candidate)) {
+        error = path + " is truncated or corrupted";
+    } else {
+        if (data) {
+            ::munmap(data, size);
+        }
+        data = mapped;
+        size = length;
+        return true;
+    }
+
+    ::munmap(mapped, length);
+    return false;
+}
+
+std::span<const SellerState> CheckpointImage::sellers() const {
+    const CheckpointHeader& h = header();
+    const auto* first = reinterpret_cast<const SellerState*>(static_cast<const char*>(data) +
+                                                             sizeof(CheckpointHeader));
+    return {first, std::size_t(h.nbExtractors) + h.nbWholesalers + h.nbFactories};
+}
+
+std::span<const LinkState> CheckpointImage::links() const {
+    std::span<const SellerState> all = sellers();
+    const auto* first = reinterpret_cast<const LinkState*>(all.data() + all.size());
+    return {first, header().nbLinks};
+}
+
+Checkpoint::TradeGuard::TradeGuard() : admitted(true), counted(false) {
+    if (!armed.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Annonce l'achat avant de regarder la porte : soit quiesce() voit
+    // l'achat et l'attend, soit l'achat voit la porte fermée
+    activeTrades.fetch_add(1);
+    if (closed.load()) {
+        activeTrades.fetch_sub(1);
+        admitted = false;
+    } else {
+        counted = true;
+    }
+}
+
+Checkpoint::TradeGuard::~TradeGuard() {
+    if (counted) {
+        activeTrades.fetch_sub(1);
+    }
+}
+
+void Checkpoint::quiesce() {
+    quiesceMutex.lock();
+    closed.store(true);
+    while (activeTrades.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void Checkpoint::resume() {
+    closed.store(false);
+    quiesceMutex.unlock();
+}
+
+bool Checkpoint::write(const std::string& path, CheckpointHeader header,
+                       std::span<const SellerState> sellers, std::span<const LinkState> links) {
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(CheckpointHeader);
+    header.sellerSize = sizeof(SellerState);
+    header.linkSize = sizeof(LinkState);
+    header.nbLinks = static_cast<std::uint32_t>(links.size());
+
+    // Écrit à côté puis renommé : un lecteur ne voit jamais un fichier partiel
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(sellers.data()),
+                  static_cast<std::streamsize>(sellers.size_bytes()));
+        out.write(reinterpret_cast<const char*>(links.data()),
+                  static_cast<std::streamsize>(links.size_bytes()));
+        if (!out) {
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void Checkpoint::run(unsigned periodMs) {
+    std::unique_lock<std::mutex> lock(runMutex);
+    while (!wakeUp.wait_for(lock, std::chrono::milliseconds(periodMs), [] { return stopping; })) {
+        lock.unlock();
+        take();
+        lock.lock();
+    }
+}
+
+void Checkpoint::start(unsigned periodMs, std::function<void()> takeCheckpoint) {
+    if (periodMs == 0 || writer.joinable()) {
+        return;
+    }
+    take = std::move(takeCheckpoint);
+    stopping = false;
+    armed = true;
+    writer = std::thread(&Checkpoint::run, periodMs);
+}
+
+void Checkpoint::stop() {
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(runMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    writer.join();
+}
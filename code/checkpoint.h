@@ -0,0 +1,189 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include "stockledger.h"
+
+// Période des points de reprise en ms, 0 : un seul, en fin de simulation
+#define CHECKPOINT_PERIOD_MS 0
+
+enum class SellerKind : std::uint8_t { Extractor, Wholesaler, Factory };
+
+/**
+ * @brief État d'un vendeur dans un point de reprise, tel qu'écrit dans le
+ *        fichier
+ */
+struct SellerState {
+    std::int32_t id;
+    SellerKind kind;
+    // ItemType extrait ou construit (Nothing pour un grossiste)
+    std::uint8_t item;
+    // Unité payée mais pas encore ajoutée au stock (mineur ou assemblage)
+    std::uint8_t inProgress;
+    // Objets listés, un bit par ItemType
+    std::uint8_t listed;
+    std::int32_t money;
+    // Employés payés depuis le début de la simulation
+    std::int32_t paidWorkers;
+    std::int32_t stocks[NB_ITEM_TYPES];
+};
+
+/**
+ * @brief Lien acheteur -> vendeur et unités échangées (voir TradeFlows)
+ */
+struct LinkState {
+    std::uint32_t buyer;
+    std::uint32_t seller;
+    std::uint64_t units;
+};
+
+/**
+ * @brief En-tête du fichier, suivi des vendeurs par identifiant croissant
+ *        puis des liens dans l'ordre de TradeFlows
+ */
+struct CheckpointHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t sellerSize;
+    std::uint32_t linkSize;
+    std::uint32_t nbExtractors;
+    std::uint32_t nbWholesalers;
+    std::uint32_t nbFactories;
+    std::uint32_t nbLinks;
+    // Liens des grossistes vers leurs fournisseurs, en tête des liens
+    std::uint32_t nbSupplyLinks;
+    std::uint32_t reserved;
+    // Temps simulé du point de reprise (voir SimClock)
+    std::uint64_t simulatedTime;
+    // Fonds de départ de la simulation d'origine, conservés d'une reprise à l'autre
+    std::int64_t startFund;
+};
+
+static_assert(sizeof(SellerState) == 16 + 4 * NB_ITEM_TYPES);
+static_assert(sizeof(LinkState) == 16);
+static_assert(sizeof(CheckpointHeader) == 64);
+
+/**
+ * @brief Point de reprise projeté en mémoire, en lecture seule.
+ *
+ * Le fichier est utilisé tel quel : les vendeurs et les liens sont lus
+ * directement dans la projection, sans aucune analyse ni copie.
+ */
+class CheckpointImage {
+public:
+    CheckpointImage() = default;
+    ~CheckpointImage();
+
+    CheckpointImage(const CheckpointImage&) = delete;
+    CheckpointImage& operator=(const CheckpointImage&) = delete;
+
+    /**
+     * @brief Projette un point de reprise et vérifie son format
+     * @return false en cas d'erreur, décrite dans error
+     */
+    bool open(const std::string& path, std::string& error);
+
+    const CheckpointHeader& header() const { return *static_cast<const CheckpointHeader*>(data); }
+
+    std::span<const SellerState> sellers() const;
+
+    std::span<const LinkState> links() const;
+
+private:
+    void* data = nullptr;
+    std::size_t size = 0;
+};
+
+/**
+ * @brief Écriture de points de reprise cohérents pendant la simulation.
+ *
+ * Une vente modifie deux vendeurs sur le thread de l'acheteur : l'argent
+ * passe de l'un à l'autre en deux temps. Pour obtenir une coupe cohérente,
+ * chaque achat est encadré par un TradeGuard ; quiesce() ferme la porte aux
+ * nouveaux achats et attend la fin de ceux en cours. Un achat refusé n'attend
+ * pas : l'acheteur le reporte à son étape suivante, ce qui ne peut bloquer ni
+ * un thread ni un ordonnanceur de coroutines. Les autres modifications d'un
+ * vendeur (salaires, production) restent sous son transactionMutex, que
+ * Seller::saveState() prend pour copier l'état.
+ *
+ * La porte n'est armée que si des points de reprise périodiques sont
+ * demandés : sinon un TradeGuard ne coûte qu'une lecture.
+ */
+class Checkpoint {
+public:
+    static constexpr std::uint32_t VERSION = 1;
+
+    /**
+     * @brief Encadre un achat, à tester avant de l'effectuer
+     */
+    class TradeGuard {
+    public:
+        TradeGuard();
+        ~TradeGuard();
+
+        TradeGuard(const TradeGuard&) = delete;
+        TradeGuard& operator=(const TradeGuard&) = delete;
+
+        /**
+         * @brief false si un point de reprise est en cours, l'achat doit
+         *        alors être reporté
+         */
+        explicit operator bool() const { return admitted; }
+
+    private:
+        bool admitted;
+        // Compté dans activeTrades
+        bool counted;
+    };
+
+    /**
+     * @brief Appelle take() toutes les periodMs ms dans un thread dédié
+     *        (0 n'en fait aucun). take() doit encadrer sa copie de l'état par
+     *        quiesce() et resume().
+     */
+    static void start(unsigned periodMs, std::function<void()> take);
+
+    static void stop();
+
+    /**
+     * @brief Refuse les nouveaux achats et attend la fin de ceux en cours
+     */
+    static void quiesce();
+
+    /**
+     * @brief Accepte de nouveau les achats
+     */
+    static void resume();
+
+    /**
+     * @brief Écrit un point de reprise dans path, remplacé d'un seul coup
+     * @return false si le fichier n'a pas pu être écrit
+     */
+    static bool write(const std::string& path, CheckpointHeader header,
+                      std::span<const SellerState> sellers, std::span<const LinkState> links);
+
+private:
+    static void run(unsigned periodMs);
+
+    static std::atomic<bool> armed;
+    static std::atomic<bool> closed;
+    static std::atomic<unsigned> activeTrades;
+    static std::mutex quiesceMutex;
+
+    static std::function<void()> take;
+    static std::mutex runMutex;
+    static std::condition_variable wakeUp;
+    static bool stopping;
+    static std::thread writer;
+};
+
+#endif // CHECKPOINT_H
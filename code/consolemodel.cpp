@@ -0,0 +1,82 @@
+/**
+ * @file consolemodel.cpp
+ * @brief Implementation of the shared console model
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "consolemodel.h"
+
+ConsoleModel::ConsoleModel(std::size_t capacity, QObject* parent)
+    : QAbstractListModel(parent), capacity(capacity), filter(ALL_ENTITIES), firstNumber(0) {}
+
+bool ConsoleModel::accepts(const Event& event) const {
+    return filter == ALL_ENTITIES || event.entity == static_cast<std::uint32_t>(filter);
+}
+
+void ConsoleModel::append(const std::vector<Event>& events) {
+    if (events.empty() || capacity == 0) {
+        return;
+    }
+
+    // Nouvelles lignes du filtre courant, insérées en un seul lot
+    std::vector<std::uint64_t> added;
+    for (const Event& event : events) {
+        if (accepts(event)) {
+            added.push_back(firstNumber + store.size());
+        }
+        store.push_back(event);
+    }
+    if (!added.empty()) {
+        int first = static_cast<int>(rows.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(added.size()) - 1);
+        rows.insert(rows.end(), added.begin(), added.end());
+        endInsertRows();
+    }
+
+    // Oublie les événements qui dépassent la capacité
+    if (store.size() > capacity) {
+        std::size_t excess = store.size() - capacity;
+        store.erase(store.begin(), store.begin() + static_cast<std::ptrdiff_t>(excess));
+        firstNumber += excess;
+
+        std::size_t stale = 0;
+        while (stale < rows.size() && rows[stale] < firstNumber) {
+            ++stale;
+        }
+        if (stale > 0) {
+            beginRemoveRows(QModelIndex(), 0, static_cast<int>(stale) - 1);
+            rows.erase(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(stale));
+            endRemoveRows();
+        }
+    }
+}
+
+void ConsoleModel::setFilter(int entity) {
+    beginResetModel();
+    filter = entity;
+    rows.clear();
+    for (std::size_t i = 0; i < store.size(); ++i) {
+        if (accepts(store[i])) {
+            rows.push_back(firstNumber + i);
+        }
+    }
+    endResetModel();
+}
+
+int ConsoleModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(rows.size());
+}
+
+QVariant ConsoleModel::data(const QModelIndex& index, int role) const {
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rowCount()) {
+        return QVariant();
+    }
+
+    const Event& event = store[rows[static_cast<std::size_t>(index.row())] - firstNumber];
+    if (filter == ALL_ENTITIES) {
+        return QString("[%1] ").arg(event.entity) + EventLog::format(event);
+    }
+    return EventLog::format(event);
+}
@@ -0,0 +1,58 @@
+#ifndef CONSOLEMODEL_H
+#define CONSOLEMODEL_H
+
+#include <QAbstractListModel>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "eventlog.h"
+
+/**
+ * @brief Modèle de la console unique : tous les événements reçus sont gardés
+ *        bruts dans un stock partagé et borné, la vue n'affiche que ceux de
+ *        l'entité choisie.
+ *
+ * Le texte d'une ligne n'est produit que lorsque la vue la demande, c'est-à-dire
+ * pour les seules lignes visibles à l'écran.
+ */
+class ConsoleModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    // Filtre affichant toutes les entités
+    static constexpr int ALL_ENTITIES = -1;
+
+    /**
+     * @param capacity Nombre d'événements gardés, les plus anciens sont oubliés
+     */
+    explicit ConsoleModel(std::size_t capacity, QObject* parent = nullptr);
+
+    /**
+     * @brief Ajoute un lot d'événements à la fin du stock
+     */
+    void append(const std::vector<Event>& events);
+
+    /**
+     * @brief N'affiche plus que les événements de entity (ou ALL_ENTITIES)
+     */
+    void setFilter(int entity);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    bool accepts(const Event& event) const;
+
+    const std::size_t capacity;
+    int filter;
+
+    // Stock partagé par tous les filtres, store[0] a le numéro firstNumber
+    std::deque<Event> store;
+    std::uint64_t firstNumber;
+
+    // Numéros des événements affichés par le filtre courant, croissants
+    std::deque<std::uint64_t> rows;
+};
+
+#endif // CONSOLEMODEL_H
@@ -1,4 +1,9 @@
 ﻿#include "display.h"
+#include <QBrush>
+#include <QPen>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
 
@@ -6,6 +11,24 @@ constexpr double SCENEWIDTH = 1000.0;
 constexpr double SCENELENGTH = 1500.0;
 constexpr double ELEMENT_WIDTH = 75.0;
 constexpr double ELEMENT_WIDTH_BIG = 150.0;
+// Au-delà de SCENEWIDTH / ELEMENT_WIDTH_BIG entités par colonne, la scène
+// s'allonge au lieu d'empiler les entités les unes sur les autres
+constexpr double MIN_ENTITY_SPACING = ELEMENT_WIDTH_BIG;
+// Entités regroupées par glyphe lorsque la vue est éloignée
+constexpr unsigned int ENTITIES_PER_GLYPH = 10;
+// Hauteur à l'écran d'une entité en dessous de laquelle on regroupe
+constexpr double LOD_MIN_PIXELS = 40.0;
+constexpr double ZOOM_STEP = 1.25;
+// Cadence de mesure des échanges et lissage du débit entre deux mesures
+constexpr int FLOW_RATE_HZ = 4;
+constexpr double FLOW_SMOOTHING = 0.7;
+// Débit (unités par seconde) sous lequel une ligne disparaît, épaisseur maximale
+constexpr double FLOW_MIN_RATE = 0.05;
+constexpr double FLOW_MAX_WIDTH = 12.0;
+// Hauteur des anciens QLabel des valeurs, dont le texte était centré verticalement
+constexpr double VALUE_CELL_HEIGHT = 30.0;
+// Remontée des valeurs de ressources par rapport à leur ligne d'icônes
+constexpr double RESOURCE_VALUE_RISE = 18.0;
 
 
 static Display* theDisplay;
@@ -17,108 +40,92 @@ ResourceItem::ResourceItem() = default;
 ProductionItem::ProductionItem() = default;
 
 
+const QPixmap& Display::pixmap(const QString& path, double width) {
+    QString key = path + '@' + QString::number(width);
+    auto it = m_pixmaps.find(key);
+    if (it == m_pixmaps.end()) {
+        it = m_pixmaps.insert(key, QPixmap(path).scaledToWidth(static_cast<int>(width),
+                                                               Qt::SmoothTransformation));
+    }
+    return *it;
+}
+
+QGraphicsSimpleTextItem* Display::addValue(double x, double y) {
+    auto value = new QGraphicsSimpleTextItem("Waiting...", m_detailLayer);
+    // Centré dans la cellule comme le texte d'un QLabel
+    value->setPos(x, y + (VALUE_CELL_HEIGHT - value->boundingRect().height()) / 2);
+    return value;
+}
+
 void Display::placeResources(int x, int y, int id, std::vector<bool> resources){
 
-    QPixmap fund(QString(":images/funds_color.png"));
-    QPixmap _fund = fund.scaledToWidth(ELEMENT_WIDTH / 3);
     auto fund_item = new ResourceItem();
     auto count = std::count(resources.begin(), resources.end(), true);
 
-    int index = -1 + (resources.size() - count) / 2;
+    int index = -1 + (static_cast<int>(resources.size()) - static_cast<int>(count)) / 2;
     int index2 = index - 2;
-    fund_item->setPixmap(_fund);
+    fund_item->setPixmap(pixmap(":images/funds_color.png", ELEMENT_WIDTH / 3));
     fund_item->setPos(x, y - 1 * (ELEMENT_WIDTH_BIG / 3) + 40);
-    m_scene->addItem(fund_item);
-    funds[id] = new QLabel(this);
-    funds[id]->setText("Waiting...");
-    int adapt = 18;
-    funds[id]->setGeometry(QRect(x-50, y + (-4) * (ELEMENT_WIDTH_BIG / 3/2) + 20, 30, 30));
-
-    if(resources[0]){
-        QPixmap petrol(QString(":images/station-essence.png"));
-        QPixmap _petrol = petrol.scaledToWidth(ELEMENT_WIDTH / 3);
-        auto petrol_item = new ResourceItem();
-        petrol_item->setPixmap(_petrol);
-        petrol_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
-        m_scene->addItem(petrol_item);
-        petrols[id] = new QLabel(this);
-        petrols[id]->setText("Waiting...");
-        petrols[id]->setGeometry(QRect(x - 50 + (ELEMENT_WIDTH_BIG), y + index2++ * (ELEMENT_WIDTH_BIG / 3/2)- adapt, 30, 30));
-    }
-
-    if(resources[1]){
-        QPixmap copper(QString(":images/copper.png"));
-        QPixmap _copper = copper.scaledToWidth(ELEMENT_WIDTH / 3);
-        auto copper_item = new ResourceItem();
-        copper_item->setPixmap(_copper);
-        copper_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
-        m_scene->addItem(copper_item);
-        coppers[id] = new QLabel(this);
-        coppers[id]->setText("Waiting...");
-        coppers[id]->setGeometry(QRect(x - 50 + (ELEMENT_WIDTH_BIG), y + index2++ * (ELEMENT_WIDTH_BIG / 3/2) - adapt, 30, 30));
-    }
-
-    if(resources[3]){
-        QPixmap sand(QString(":images/sand.png"));
-        QPixmap _sand = sand.scaledToWidth(ELEMENT_WIDTH / 3);
-        auto sand_item = new ResourceItem();
-        sand_item->setPixmap(_sand);
-        sand_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
-        m_scene->addItem(sand_item);
-        sands[id] = new QLabel(this);
-        sands[id]->setText("Waiting...");
-        sands[id]->setGeometry(QRect(x - 50 + (ELEMENT_WIDTH_BIG), y + index2++ * (ELEMENT_WIDTH_BIG / 3/2)- adapt, 30, 30));
-    }
-    if(resources[2]){
-        QPixmap chip(QString(":images/Microchips.png"));
-        QPixmap _chip = chip.scaledToWidth(ELEMENT_WIDTH / 3);
-        auto chip_item = new ResourceItem();
-        chip_item->setPixmap(_chip);
-        chip_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
-        m_scene->addItem(chip_item);
-        chips[id] = new QLabel(this);
-        chips[id]->setText("Waiting...");
-        chips[id]->setGeometry(QRect(x - 50 + (ELEMENT_WIDTH_BIG), y + index2++ * (ELEMENT_WIDTH_BIG / 3/2)- adapt, 30, 30));
-    }
-    if(resources[5]){
-        QPixmap plastic(QString(":images/Plastics.png"));
-        QPixmap _plastic = plastic.scaledToWidth(ELEMENT_WIDTH / 3);
-        auto plastic_item = new ResourceItem();
-        plastic_item->setPixmap(_plastic);
-        plastic_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
-        m_scene->addItem(plastic_item);
-        plastics[id] = new QLabel(this);
-        plastics[id]->setText("Waiting...");
-        plastics[id]->setGeometry(QRect(x - 50 + (ELEMENT_WIDTH_BIG), y + index2++ * (ELEMENT_WIDTH_BIG / 3/2)- adapt, 30, 30));
-    }
-    if(resources[4]){
-        QPixmap robot(QString(":images/Service_bots.png"));
-        QPixmap _robot = robot.scaledToWidth(ELEMENT_WIDTH / 3);
-        auto robot_item = new ResourceItem();
-        robot_item->setPixmap(_robot);
-        robot_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
-        m_scene->addItem(robot_item);
-        robots[id] = new QLabel(this);
-        robots[id]->setText("Waiting...");
-        robots[id]->setGeometry(QRect(x - 50 + (ELEMENT_WIDTH_BIG), y + index2++ * (ELEMENT_WIDTH_BIG / 3/2)- adapt, 30, 30));
+    fund_item->setParentItem(m_detailLayer);
+    funds[id] = addValue(x - 50, y + (-4) * (ELEMENT_WIDTH_BIG / 3/2) + 20);
+
+    // Ordre d'affichage des ressources et indice dans resourceAssociations
+    const struct {
+        std::size_t slot;
+        const char* image;
+        std::vector<QGraphicsSimpleTextItem*>& values;
+    } icons[] = {{0, ":images/station-essence.png", petrols},
+                 {1, ":images/copper.png", coppers},
+                 {3, ":images/sand.png", sands},
+                 {2, ":images/Microchips.png", chips},
+                 {5, ":images/Plastics.png", plastics},
+                 {4, ":images/Service_bots.png", robots}};
+
+    for (const auto& icon : icons) {
+        if (!resources[icon.slot]) {
+            continue;
+        }
+        auto resource_item = new ResourceItem();
+        resource_item->setPixmap(pixmap(icon.image, ELEMENT_WIDTH / 3));
+        resource_item->setPos(x + (ELEMENT_WIDTH_BIG), y + index++ * (ELEMENT_WIDTH_BIG / 3/2));
+        resource_item->setParentItem(m_detailLayer);
+        icon.values[id] = addValue(x - 50 + (ELEMENT_WIDTH_BIG),
+                                   y + index2++ * (ELEMENT_WIDTH_BIG / 3/2) - RESOURCE_VALUE_RISE);
     }
 }
 
-Display::Display(unsigned int nbExtractors, unsigned int nbFactories, unsigned int nbWholesalers, QWidget *parent) :
-    QGraphicsView(parent)
+Display::Display(const std::vector<ItemType>& extractors, const std::vector<ItemType>& factories,
+                 unsigned int nbWholesalers, QWidget *parent) :
+    QGraphicsView(parent), m_aggregated(false), m_flows(nullptr)
 {
     theDisplay = this;
+    unsigned int nbExtractors = static_cast<unsigned int>(extractors.size());
+    unsigned int nbFactories = static_cast<unsigned int>(factories.size());
+    unsigned int nbEntities = nbExtractors + nbFactories + nbWholesalers;
+    m_nbExtractors = nbExtractors;
+    m_nbWholesalers = nbWholesalers;
 
     m_scene = new QGraphicsScene(this);
-    createResourceAssociations(nbExtractors, nbWholesalers, nbFactories);
-
-    funds = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
-    petrols = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
-    coppers = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
-    sands = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
-    chips = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
-    robots = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
-    plastics = std::vector<QLabel*>(nbExtractors + nbFactories + nbWholesalers);
+    createResourceAssociations(extractors, nbWholesalers, factories);
+
+    // Les couches sont de simples parents, elles ne dessinent rien
+    m_detailLayer = new QGraphicsRectItem;
+    m_detailLayer->setFlag(QGraphicsItem::ItemHasNoContents);
+    m_scene->addItem(m_detailLayer);
+    m_aggregateLayer = new QGraphicsRectItem;
+    m_aggregateLayer->setFlag(QGraphicsItem::ItemHasNoContents);
+    m_aggregateLayer->setVisible(false);
+    m_scene->addItem(m_aggregateLayer);
+
+    funds = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    petrols = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    coppers = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    sands = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    chips = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    robots = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    plastics = std::vector<QGraphicsSimpleTextItem*>(nbEntities);
+    m_fundValues = std::vector<unsigned>(nbEntities, 0);
+    m_aggregateOf = std::vector<unsigned int>(nbEntities, 0);
 
     penColors.push_back(Qt::cyan);
     penColors.push_back(Qt::red);
@@ -132,75 +139,146 @@ Display::Display(unsigned int nbExtractors, unsigned int nbFactories, unsigned i
     this->setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
     this->setMinimumHeight(SCENEWIDTH);
     this->setMinimumWidth(SCENELENGTH);
+    this->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
     this->setScene(m_scene);
 
+    auto spacing = [](unsigned int count) {
+        return std::max(SCENEWIDTH / std::max(count, 1U), MIN_ENTITY_SPACING);
+    };
+    m_spacing = std::min({spacing(nbExtractors), spacing(nbWholesalers), spacing(nbFactories)});
+
+    double extractorSpacing = spacing(nbExtractors);
     for (unsigned int i = 0; i < nbExtractors; ++i){
         QString str;
-        switch(i % 3){
-            case 0:
+        switch(extractors[i]){
+            case ItemType::Sand:
                 str = ":images/sand_scaled.png";
                 break;
-            case 1:
+            case ItemType::Copper:
                 str = ":images/copper_scaled.png";
                 break;
-            case 2:
+            default:
                 str = ":images/petrol_scaled.png";
                 break;
         }
 
-        QPixmap img(str);
-        QPixmap extractorPixmap;
         int x = 0 + SCENELENGTH / 6;//QRandomGenerator::system()->bounded(SCENELENGTH / 3);
-        int y = (SCENEWIDTH / nbExtractors) * i + SCENEWIDTH / nbExtractors / 2;
+        int y = static_cast<int>(extractorSpacing * i + extractorSpacing / 2);
 
-        extractorPixmap = img.scaledToWidth(ELEMENT_WIDTH_BIG);
         auto extractor = new ProductionItem();
-        extractor->setPixmap(extractorPixmap);
+        extractor->setPixmap(pixmap(str, ELEMENT_WIDTH_BIG));
         extractor->setPos(x, y);
-        m_scene->addItem(extractor);
+        extractor->setParentItem(m_detailLayer);
         m_productItem.push_back(extractor);
 
         placeResources(x, y, i, resourceAssociations[i]);
     }
 
+    double wholesalerSpacing = spacing(nbWholesalers);
     for (unsigned int i = 0; i < nbWholesalers; ++i) {
-        QPixmap img(QString(":images/warehouse_scaled.png"));
-        QPixmap wholesalerPixmap;
         int x = (SCENELENGTH / 3) + (SCENELENGTH / 6);
 //        int x = (SCENELENGTH / 3) * 2 + (SCENELENGTH / 6);//QRandomGenerator::system()->bounded(SCENELENGTH / 3);
-        int y = (SCENEWIDTH / nbWholesalers) * i + SCENEWIDTH / nbWholesalers / 2;
+        int y = static_cast<int>(wholesalerSpacing * i + wholesalerSpacing / 2);
 
-        wholesalerPixmap = img.scaledToWidth(ELEMENT_WIDTH_BIG);
         auto wholesaler = new ProductionItem();
-        wholesaler->setPixmap(wholesalerPixmap);
+        wholesaler->setPixmap(pixmap(":images/warehouse_scaled.png", ELEMENT_WIDTH_BIG));
 
         wholesaler->setPos(x, y);
-        m_scene->addItem(wholesaler);
+        wholesaler->setParentItem(m_detailLayer);
         m_productItem.push_back(wholesaler);
 
         placeResources(x, y, i + nbExtractors, resourceAssociations[i + nbExtractors]);
     }
 
+    double factorySpacing = spacing(nbFactories);
     for (unsigned int i = 0; i < nbFactories; ++i) {
-        QPixmap img(QString(":images/factory_scaled.png"));
-        QPixmap factoryPixmap;
         int x = (SCENELENGTH / 3) * 2 + (SCENELENGTH / 6);
 //        int x = (SCENELENGTH / 3) + (SCENELENGTH / 6);//QRandomGenerator::system()->bounded(SCENELENGTH / 3);
-        int y = (SCENEWIDTH / nbFactories) * i + SCENEWIDTH / nbFactories / 2;
+        int y = static_cast<int>(factorySpacing * i + factorySpacing / 2);
 
-        factoryPixmap = img.scaledToWidth(ELEMENT_WIDTH_BIG);
         auto factory = new ProductionItem();
-        factory->setPixmap(factoryPixmap);
+        factory->setPixmap(pixmap(":images/factory_scaled.png", ELEMENT_WIDTH_BIG));
         factory->setPos(x, y);
-        m_scene->addItem(factory);
+        factory->setParentItem(m_detailLayer);
         m_productItem.push_back(factory);
 
         placeResources(x, y, i + nbExtractors + nbWholesalers, resourceAssociations[i + nbWholesalers + nbExtractors]);
 
     }
+
+    addAggregates(SCENELENGTH / 6, 0, nbExtractors, "Mines", Qt::darkYellow);
+    addAggregates((SCENELENGTH / 3) + (SCENELENGTH / 6), nbExtractors, nbWholesalers,
+                  "Wholesalers", Qt::darkCyan);
+    addAggregates((SCENELENGTH / 3) * 2 + (SCENELENGTH / 6), nbExtractors + nbWholesalers,
+                  nbFactories, "Factories", Qt::darkRed);
+    updateLevelOfDetail();
+
+    connect(&m_flowTimer, &QTimer::timeout, this, &Display::updateFlows);
+}
+
+void Display::addAggregates(double x, unsigned int first, unsigned int count, const QString& name,
+                            const QColor& color) {
+    for (unsigned int start = 0; start < count; start += ENTITIES_PER_GLYPH) {
+        unsigned int end = std::min(start + ENTITIES_PER_GLYPH, count) - 1;
+        QPointF top = m_productItem[first + start]->pos();
+        QPointF bottom = m_productItem[first + end]->pos();
+
+        auto glyph = new QGraphicsRectItem(x, top.y(), ELEMENT_WIDTH_BIG,
+                                           bottom.y() - top.y() + ELEMENT_WIDTH_BIG,
+                                           m_aggregateLayer);
+        glyph->setBrush(QColor(color.red(), color.green(), color.blue(), 96));
+        glyph->setPen(QPen(color, 2));
+
+        // Le texte garde sa taille quel que soit le zoom
+        auto text = new QGraphicsSimpleTextItem(glyph);
+        text->setFlag(QGraphicsItem::ItemIgnoresTransformations);
+        text->setPos(x, top.y());
+
+        for (unsigned int id = first + start; id <= first + end; ++id) {
+            m_aggregateOf[id] = static_cast<unsigned int>(m_aggregates.size());
+        }
+        m_aggregates.push_back({first + start, first + end, name, glyph->rect(), text});
+    }
+}
+
+void Display::refreshAggregate(unsigned int aggregate) {
+    Aggregate& glyph = m_aggregates[aggregate];
+    unsigned long long total = 0;
+    for (unsigned int id = glyph.first; id <= glyph.last; ++id) {
+        total += m_fundValues[id];
+    }
+    glyph.text->setText(QString("%1 %2-%3\n%4").arg(glyph.name).arg(glyph.first)
+                        .arg(glyph.last).arg(total));
+}
+
+void Display::updateLevelOfDetail() {
+    bool aggregated = m_spacing * transform().m11() < LOD_MIN_PIXELS;
+    if (aggregated == m_aggregated) {
+        return;
+    }
+
+    m_aggregated = aggregated;
+    if (aggregated) {
+        // Les glyphes ne sont pas tenus à jour tant qu'ils sont cachés
+        for (unsigned int i = 0; i < m_aggregates.size(); ++i) {
+            refreshAggregate(i);
+        }
+    }
+    m_detailLayer->setVisible(!aggregated);
+    m_aggregateLayer->setVisible(aggregated);
+}
+
+void Display::wheelEvent(QWheelEvent *event) {
+    double factor = event->angleDelta().y() > 0 ? ZOOM_STEP : 1.0 / ZOOM_STEP;
+    scale(factor, factor);
+    updateLevelOfDetail();
+    event->accept();
 }
 
-void Display::createResourceAssociations(unsigned int nbExtractors, unsigned int nbWholesalers, unsigned int nbFactories) {
+void Display::createResourceAssociations(const std::vector<ItemType>& extractors, unsigned int nbWholesalers,
+                                         const std::vector<ItemType>& factories) {
+    unsigned int nbExtractors = extractors.size();
+    unsigned int nbFactories = factories.size();
     unsigned int totalEntities = nbExtractors + nbWholesalers + nbFactories;
     resourceAssociations.resize(totalEntities, std::vector<bool>(6, false));
 
@@ -209,11 +287,11 @@ void Display::createResourceAssociations(unsigned int nbExtractors, unsigned int
     // Remplissez le vecteur resourceAssociations en fonction du nombre d'entités de chaque type
     for (unsigned int i = 0; i < nbExtractors; ++i) {
         std::vector<bool> extractorResources(6, false);
-        if (i % 3 == 0) {
+        if (extractors[i] == ItemType::Sand) {
             extractorResources[3] = true; // Extracteur de sable
-        } else if (i % 3 == 1) {
+        } else if (extractors[i] == ItemType::Copper) {
             extractorResources[1] = true; // Extracteur de cuivre
-        } else if (i % 3 == 2) {
+        } else {
             extractorResources[0] = true; // Extracteur de pétrole
         }
         resourceAssociations[i] = extractorResources;
@@ -227,14 +305,14 @@ void Display::createResourceAssociations(unsigned int nbExtractors, unsigned int
 
     for (unsigned int i = 0; i < nbFactories; ++i) {
         std::vector<bool> factoryResources(6, false);
-        if (i % 3 == 0) {
+        if (factories[i] == ItemType::Plastic) {
             factoryResources[0] = true; // Usine à plastique
             factoryResources[5] = true; // Usine à plastique
-        } else if (i % 3 == 1) {
+        } else if (factories[i] == ItemType::Chip) {
             factoryResources[2] = true; // Usine à puce (chip)
             factoryResources[1] = true; // Usine à puce (chip)
             factoryResources[3] = true; // Usine à puce (chip)
-        } else if (i % 3 == 2) {
+        } else {
             factoryResources[2] = true; // Usine à robot
             factoryResources[4] = true; // Usine à robot
             factoryResources[5] = true; // Usine à robot
@@ -244,64 +322,147 @@ void Display::createResourceAssociations(unsigned int nbExtractors, unsigned int
 
 }
 
-void Display::update_fund(int idx, QString fund) {
-    this->funds[idx]->setText(fund);
+void Display::update_fund(int idx, unsigned fund) {
+    m_fundValues[idx] = fund;
+    this->funds[idx]->setText(QString::number(fund));
+    if (m_aggregated) {
+        refreshAggregate(m_aggregateOf[idx]);
+    }
+}
+
+bool Display::isWholesaler(unsigned int id) const {
+    return id >= m_nbExtractors && id < m_nbExtractors + m_nbWholesalers;
 }
 
-void Display::set_link(int from, int to){
-    QPoint pFrom(m_productItem[from]->pos().x(), m_productItem[from]->pos().y());
-    QPoint pTo(m_productItem[to]->pos().x(), m_productItem[to]->pos().y());
-    QLine line;
-    if(pFrom.x() > SCENELENGTH/2){
-        /*Link Factory -> Wholesaler*/
-        line = QLine(QPoint(pFrom.x(), pFrom.y() + (m_productItem[from]->pixmap().height()/2)),
-                     QPoint(pTo.x() + ((ELEMENT_WIDTH)*2) + 50, pTo.y() + (m_productItem[to]->pixmap().height()/2)));
-        QPen pen(penColors[6 % penColors.size()]);
-        pen.setWidth(2);
-
-        m_scene->addLine(line, pen);
+QLineF Display::flowLine(unsigned int buyer, unsigned int seller, bool aggregated) const {
+    // Extrémités : bord droit de l'entité de gauche, bord gauche de celle de droite
+    QPointF left;
+    QPointF right;
+    if (aggregated) {
+        QRectF a = m_aggregates[buyer].rect;
+        QRectF b = m_aggregates[seller].rect;
+        if (a.x() > b.x()) {
+            std::swap(a, b);
+        }
+        left = QPointF(a.right(), a.center().y());
+        right = QPointF(b.left(), b.center().y());
     } else {
-        if(pTo.x() > SCENELENGTH/2){
-            /*Link Wholesaler -> Factory*/
-            line = QLine(QPoint(pTo.x(), pTo.y() + (m_productItem[to]->pixmap().height()/2)),
-                         QPoint(pFrom.x() + ((ELEMENT_WIDTH)*2) + 50, pFrom.y() + (m_productItem[from]->pixmap().height()/2)));
-            QPen pen(penColors[from % penColors.size()]);
-            pen.setWidth(2);
-
-            m_scene->addLine(line, pen);
-        } else {
-            /*Link Wholesaler -> Extractor*/
-            line = QLine(QPoint(pFrom.x(), pFrom.y() + (m_productItem[from]->pixmap().height()/2)),
-                         QPoint(pTo.x() + ((ELEMENT_WIDTH)*2), pTo.y() + (m_productItem[to]->pixmap().height()/2)));
-            QPen pen(penColors[from % penColors.size()]);
-            pen.setWidth(2);
+        unsigned int l = buyer;
+        unsigned int r = seller;
+        if (m_productItem[l]->pos().x() > m_productItem[r]->pos().x()) {
+            std::swap(l, r);
+        }
+        // Les stocks d'un grossiste débordent plus à droite que ceux d'une mine
+        double width = ELEMENT_WIDTH * 2 + (isWholesaler(l) ? 50 : 0);
+        left = m_productItem[l]->pos() + QPointF(width, m_productItem[l]->pixmap().height() / 2);
+        right = m_productItem[r]->pos() + QPointF(0, m_productItem[r]->pixmap().height() / 2);
+    }
+    return QLineF(left, right);
+}
 
-            m_scene->addLine(line, pen);
+void Display::setTradeFlows(TradeFlows* flows) {
+    m_flows = flows;
+    // Les unités d'un point de reprise ne comptent pas dans le débit
+    m_lastUnits.resize(flows->size());
+    for (std::size_t i = 0; i < flows->size(); ++i) {
+        m_lastUnits[i] = flows->units(i);
+    }
+    m_flowTimer.start(1000 / FLOW_RATE_HZ);
+}
+
+void Display::updateFlows() {
+    // Seuls les liens ayant vu passer des unités depuis la dernière mesure
+    // touchent aux lignes, qui ne sont créées qu'au premier échange
+    m_flows->forEachChanged([this](std::size_t i) {
+        std::uint64_t units = m_flows->units(i);
+        if (units == m_lastUnits[i]) {
+            return;
+        }
+        std::uint64_t delta = units - m_lastUnits[i];
+        m_lastUnits[i] = units;
+
+        const TradeFlows::Link& link = m_flows->link(i);
+        auto key = [](std::uint64_t buyer, std::uint64_t seller) { return buyer << 32 | seller; };
+        addFlow(m_entityFlows, key(link.buyer, link.seller), delta);
+        addFlow(m_aggregateFlows, key(m_aggregateOf[link.buyer], m_aggregateOf[link.seller]), delta);
+    });
+
+    updateFlowLines(m_entityFlows, m_detailLayer, false);
+    updateFlowLines(m_aggregateFlows, m_aggregateLayer, true);
+}
+
+void Display::addFlow(FlowLayer& flows, std::uint64_t key, std::uint64_t units) {
+    Flow& flow = flows.flows[key];
+    flow.pending += units;
+    if (!flow.listed) {
+        flow.listed = true;
+        flows.active.push_back(key);
+    }
+}
+
+void Display::updateFlowLines(FlowLayer& flows, QGraphicsItem *layer, bool aggregated) {
+    bool visible = aggregated == m_aggregated;
+    for (std::size_t i = 0; i < flows.active.size();) {
+        std::uint64_t key = flows.active[i];
+        Flow& flow = flows.flows[key];
+        flow.rate = flow.rate * FLOW_SMOOTHING +
+                    static_cast<double>(flow.pending) * FLOW_RATE_HZ * (1.0 - FLOW_SMOOTHING);
+        flow.pending = 0;
+
+        // Les lignes de la couche cachée ne sont mises à jour qu'une fois affichées
+        bool active = flow.rate >= FLOW_MIN_RATE;
+        if (visible && (flow.line || active)) {
+            unsigned int buyer = static_cast<unsigned int>(key >> 32);
+            if (!flow.line) {
+                flow.line = new QGraphicsLineItem(
+                    flowLine(buyer, static_cast<unsigned int>(key & 0xFFFFFFFFU), aggregated), layer);
+                flow.line->setZValue(-1);
+            }
+            flow.line->setVisible(active);
+
+            // Épaisseur par demi-pixel pour ne pas redessiner à chaque variation
+            double width = std::round(2 * std::min(1.0 + std::log2(1.0 + flow.rate), FLOW_MAX_WIDTH)) / 2;
+            if (active && flow.line->pen().widthF() != width) {
+                QPen pen(penColors[buyer % penColors.size()]);
+                pen.setWidthF(width);
+                flow.line->setPen(pen);
+            }
+        }
+
+        // Un flux tari dont la ligne est cachée quitte la liste jusqu'au
+        // prochain échange
+        if (!active && (!flow.line || !flow.line->isVisible())) {
+            flow.rate = 0.0;
+            flow.listed = false;
+            flows.active[i] = flows.active.back();
+            flows.active.pop_back();
+        } else {
+            ++i;
         }
     }
 }
 
-void Display::update_stocks(int idx, std::map<ItemType, int>* stocks) {
+void Display::update_stocks(int idx, const StockLedger& stocks) {
 
     std::vector<bool> updates = resourceAssociations[idx];
 
     if(updates[0]){
-        this->petrols[idx]->setText(QString::number((*stocks)[ItemType::Petrol]));
+        this->petrols[idx]->setText(QString::number(stocks.get(ItemType::Petrol)));
     }
     if(updates[1]){
-        this->coppers[idx]->setText(QString::number((*stocks)[ItemType::Copper]));
+        this->coppers[idx]->setText(QString::number(stocks.get(ItemType::Copper)));
     }
     if(updates[2]){
-        this->chips[idx]->setText(QString::number((*stocks)[ItemType::Chip]));
+        this->chips[idx]->setText(QString::number(stocks.get(ItemType::Chip)));
     }
     if(updates[3]){
-        this->sands[idx]->setText(QString::number((*stocks)[ItemType::Sand]));
+        this->sands[idx]->setText(QString::number(stocks.get(ItemType::Sand)));
     }
     if(updates[4]){
-        this->robots[idx]->setText(QString::number((*stocks)[ItemType::Robot]));
+        this->robots[idx]->setText(QString::number(stocks.get(ItemType::Robot)));
     }
     if(updates[5]){
-        this->plastics[idx]->setText(QString::number((*stocks)[ItemType::Plastic]));
+        this->plastics[idx]->setText(QString::number(stocks.get(ItemType::Plastic)));
     }
 
 }
@@ -3,11 +3,14 @@
 
 #include <QGraphicsView>
 #include <QGraphicsItem>
+#include <QHash>
+#include <QTimer>
+#include <unordered_map>
 #include <pcosynchro/pcosemaphore.h>
-#include <QLabel>
 #include <QLine>
 
 #include "seller.h"
+#include "tradeflows.h"
 
 class ResourceItem : public QObject, public QGraphicsPixmapItem {
     Q_OBJECT
@@ -53,34 +56,115 @@ class Display : public QGraphicsView
 {
     Q_OBJECT
 public:
-    Display(unsigned int nbExtractors, unsigned int nbFactories, unsigned int nbWholesalers, QWidget *parent);
+    Display(const std::vector<ItemType>& extractors, const std::vector<ItemType>& factories,
+            unsigned int nbWholesalers, QWidget *parent);
     //~Display();
 
-    std::vector<QLabel*> funds;
-    std::vector<QLabel*> petrols;
-    std::vector<QLabel*> coppers;
-    std::vector<QLabel*> chips;
-    std::vector<QLabel*> sands;
-    std::vector<QLabel*> robots;
-    std::vector<QLabel*> plastics;
+    // Textes de la scène, bien plus légers qu'un QLabel par valeur
+    std::vector<QGraphicsSimpleTextItem*> funds;
+    std::vector<QGraphicsSimpleTextItem*> petrols;
+    std::vector<QGraphicsSimpleTextItem*> coppers;
+    std::vector<QGraphicsSimpleTextItem*> chips;
+    std::vector<QGraphicsSimpleTextItem*> sands;
+    std::vector<QGraphicsSimpleTextItem*> robots;
+    std::vector<QGraphicsSimpleTextItem*> plastics;
 
     std::vector<QColor> penColors;
 
     std::vector<ProductionItem*> m_productItem;
 
 
-    void update_stocks(int idx, std::map<ItemType, int>* stocks);
-    void update_fund(int idx, QString fund);
+    void update_stocks(int idx, const StockLedger& stocks);
+    void update_fund(int idx, unsigned fund);
 
-    void set_link(int from, int to);
+    /**
+     * @brief Dessine les échanges mesurés par flows, qui doit rester valide
+     *        tant que l'affichage existe
+     */
+    void setTradeFlows(TradeFlows* flows);
+
+protected:
+    /**
+     * @brief La molette zoome la vue
+     */
+    void wheelEvent(QWheelEvent *event) override;
 
 private:
     QGraphicsScene *m_scene;
 
     std::vector<std::vector<bool>> resourceAssociations;
 
+    // Images chargées et mises à l'échelle une seule fois, partagées par
+    // toutes les entités (clé : chemin et largeur)
+    QHash<QString, QPixmap> m_pixmaps;
+
+    // Détail de chaque entité, ou glyphes regroupant plusieurs entités
+    // lorsque la vue est trop éloignée pour les distinguer
+    QGraphicsItem *m_detailLayer;
+    QGraphicsItem *m_aggregateLayer;
+    bool m_aggregated;
+    // Distance verticale entre deux entités d'une même colonne
+    double m_spacing;
+
+    struct Aggregate {
+        unsigned int first;
+        unsigned int last;
+        QString name;
+        QRectF rect;
+        QGraphicsSimpleTextItem *text;
+    };
+    std::vector<Aggregate> m_aggregates;
+    std::vector<unsigned int> m_aggregateOf;
+    std::vector<unsigned> m_fundValues;
+
+    unsigned int m_nbExtractors;
+    unsigned int m_nbWholesalers;
+
+    /**
+     * @brief Échanges entre deux entités (vue détaillée) ou deux glyphes (vue
+     *        regroupée), une seule ligne quel que soit le nombre de liens
+     */
+    struct Flow {
+        QGraphicsLineItem *line;
+        // Débit lissé en unités par seconde
+        double rate;
+        // Unités reçues depuis la dernière mesure
+        std::uint64_t pending;
+        // Présent dans la liste des flux actifs de sa couche
+        bool listed;
+    };
+
+    /**
+     * @brief Flux d'une vue. Seuls les flux actifs (débit non nul ou ligne
+     *        encore affichée) sont parcourus à chaque mesure.
+     */
+    struct FlowLayer {
+        std::unordered_map<std::uint64_t, Flow> flows;
+        std::vector<std::uint64_t> active;
+    };
+
+    TradeFlows *m_flows;
+    std::vector<std::uint64_t> m_lastUnits;
+    FlowLayer m_entityFlows;
+    FlowLayer m_aggregateFlows;
+    QTimer m_flowTimer;
+
+    void updateFlows();
+    void addFlow(FlowLayer& flows, std::uint64_t key, std::uint64_t units);
+    void updateFlowLines(FlowLayer& flows, QGraphicsItem *layer, bool aggregated);
+    QLineF flowLine(unsigned int buyer, unsigned int seller, bool aggregated) const;
+    bool isWholesaler(unsigned int id) const;
+
+    const QPixmap& pixmap(const QString& path, double width);
+    QGraphicsSimpleTextItem* addValue(double x, double y);
+    void addAggregates(double x, unsigned int first, unsigned int count, const QString& name,
+                       const QColor& color);
+    void refreshAggregate(unsigned int aggregate);
+    void updateLevelOfDetail();
+
     void placeResources(int x, int y, int id, std::vector<bool> resources);
-    void createResourceAssociations(unsigned int nbExtractors, unsigned int nbWholesalers, unsigned int nbFactories);
+    void createResourceAssociations(const std::vector<ItemType>& extractors, unsigned int nbWholesalers,
+                                    const std::vector<ItemType>& factories);
 public slots:
 
 };
@@ -0,0 +1,109 @@
+/**
+ * @file eventlog.cpp
+ * @brief Implementation of the bounded binary event log
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "eventlog.h"
+#include <QStringBuilder>
+#include <algorithm>
+#include "seller.h"
+#include "simclock.h"
+
+std::size_t EventLog::capacity = EVENT_LOG_CAPACITY;
+EventLog::Retention EventLog::retention = EventLog::Retention::KeepLatest;
+std::mutex EventLog::registryMutex;
+std::vector<std::unique_ptr<EventLog::Ring>> EventLog::rings;
+
+void EventLog::configure(std::size_t eventCapacity, Retention eventRetention) {
+    capacity  = eventCapacity;
+    retention = eventRetention;
+}
+
+std::size_t EventLog::getCapacity() {
+    return capacity;
+}
+
+EventLog::Retention EventLog::getRetention() {
+    return retention;
+}
+
+EventLog::Ring* EventLog::threadRing() {
+    thread_local Ring* ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        rings.push_back(std::make_unique<Ring>(capacity));
+        ring = rings.back().get();
+    }
+    return ring;
+}
+
+void EventLog::record(int entity, EventCode code, int a, int b, int c) {
+    if (capacity == 0) {
+        return;
+    }
+
+    Ring* ring = threadRing();
+    std::uint64_t index = ring->head.load(std::memory_order_relaxed);
+    if (retention == Retention::KeepOldest && index >= ring->capacity) {
+        return;
+    }
+
+    ring->cells[index % ring->capacity].store(Event{index, SimClock::now(), static_cast<std::uint32_t>(entity), code, {a, b, c}});
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+std::vector<Event> EventLog::Reader::collect() {
+    std::vector<Event> events;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    positions.resize(rings.size(), 0);
+    for (std::size_t r = 0; r < rings.size(); ++r) {
+        const Ring& ring = *rings[r];
+        std::uint64_t head  = ring.head.load(std::memory_order_acquire);
+        std::uint64_t first = head > ring.capacity ? head - ring.capacity : 0;
+        for (std::uint64_t i = std::max(positions[r], first); i < head; ++i) {
+            Event event = ring.cells[i % ring.capacity].load().value;
+            // Écrasé entre-temps par un événement plus récent
+            if (event.index == i) {
+                events.push_back(event);
+            }
+        }
+        positions[r] = head;
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& l, const Event& r) { return l.time < r.time; });
+    return events;
+}
+
+QString EventLog::format(const Event& event) {
+    const auto item = [&event](int i) { return getItemName(static_cast<ItemType>(event.args[i])); };
+
+    switch (event.code) {
+        case EventCode::MineCreated : return "Mine Created";
+        case EventCode::MineStarted : return "[START] Mine routine";
+        case EventCode::Mined : return QString("1 ") % item(0) % " has been mined";
+        case EventCode::MineStopped : return "[STOP] Mine routine";
+        case EventCode::FactoryCreated : return "Factory created";
+        case EventCode::FactoryStarted : return "[START] Factory routine";
+        case EventCode::ItemBuilt : return "Factory have build a new object";
+        case EventCode::FactoryStopped : return "[STOP] Factory routine";
+        case EventCode::WholesalerCreated : return "Wholesaler Created";
+        case EventCode::WholesalerStarted : return "[START] Wholesaler routine";
+        case EventCode::PurchaseIntent :
+            return QString("I would like to buy %1 of ").arg(event.args[0]) % item(1) %
+                   QString(" which would cost me %1").arg(event.args[2]);
+        case EventCode::WholesalerStopped : return "[STOP] Wholesaler routine";
+        default : return "???";
+    }
+}
+
+void EventLog::dump(std::ostream& out) {
+    Reader reader;
+    reader.poll([&out](const Event& event) {
+        out << "console " << event.entity << ' ' << format(event).toStdString() << '\n';
+    });
+}
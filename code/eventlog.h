@@ -0,0 +1,136 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "seqlock.h"
+
+// Nombre d'événements gardés par thread
+#define EVENT_LOG_CAPACITY 1024
+
+/**
+ * @brief Type d'un événement du journal, chacun a son propre texte (voir
+ *        EventLog::format())
+ */
+enum class EventCode : std::uint16_t {
+    MineCreated,
+    MineStarted,
+    Mined,              // args : objet
+    MineStopped,
+    FactoryCreated,
+    FactoryStarted,
+    ItemBuilt,
+    FactoryStopped,
+    WholesalerCreated,
+    WholesalerStarted,
+    PurchaseIntent,     // args : quantité, objet, prix
+    WholesalerStopped
+};
+
+/**
+ * @brief Événement brut : un code et des arguments entiers, mis en forme
+ *        seulement à la lecture
+ */
+struct Event {
+    // Position dans le tampon de son thread
+    std::uint64_t index;
+    // Temps simulé de l'événement (voir SimClock)
+    std::uint64_t time;
+    std::uint32_t entity;
+    EventCode code;
+    std::int32_t args[3];
+};
+
+/**
+ * @brief Journal d'événements binaire et borné, remplaçant le texte formaté
+ *        à chaque notification.
+ *
+ * Chaque thread écrit dans son propre tampon circulaire, sans verrou ni
+ * allocation : un événement est un code et trois entiers. Le texte n'est
+ * produit que par format(), lorsqu'un événement est effectivement affiché ou
+ * écrit dans un fichier. La mémoire est bornée à capacity événements par
+ * thread ; une fois le tampon plein, la politique de rétention décide si les
+ * plus anciens sont écrasés ou si les nouveaux sont ignorés.
+ */
+class EventLog {
+public:
+    enum class Retention { KeepLatest, KeepOldest };
+
+    /**
+     * @brief Lit les événements arrivés depuis le dernier appel à poll().
+     *        Un lecteur ne doit être utilisé que par un thread à la fois.
+     */
+    class Reader {
+    public:
+        /**
+         * @brief Appelle apply(const Event&) pour chaque nouvel événement
+         *        encore présent, dans l'ordre du temps simulé
+         */
+        template<typename F>
+        void poll(F&& apply) {
+            for (const Event& event : collect()) {
+                apply(event);
+            }
+        }
+
+    private:
+        std::vector<Event> collect();
+
+        // Prochain index à lire dans chaque tampon
+        std::vector<std::uint64_t> positions;
+    };
+
+    /**
+     * @brief Taille des tampons et politique de rétention, capacity = 0
+     *        désactive le journal. Doit être appelé avant le lancement des threads.
+     */
+    static void configure(std::size_t capacity, Retention retention);
+
+    static std::size_t getCapacity();
+
+    static Retention getRetention();
+
+    /**
+     * @brief Enregistre un événement dans le tampon du thread appelant
+     */
+    static void record(int entity, EventCode code, int a = 0, int b = 0, int c = 0);
+
+    /**
+     * @brief Texte de l'événement
+     */
+    static QString format(const Event& event);
+
+    /**
+     * @brief Écrit tous les événements conservés, un par ligne
+     */
+    static void dump(std::ostream& out);
+
+private:
+    struct Ring {
+        explicit Ring(std::size_t capacity)
+            : capacity(capacity), cells(std::make_unique<SeqLock<Event>[]>(capacity)) {}
+
+        const std::size_t capacity;
+        std::unique_ptr<SeqLock<Event>[]> cells;
+        // Nombre d'événements écrits depuis la création
+        std::atomic<std::uint64_t> head{0};
+    };
+
+    static Ring* threadRing();
+
+    static std::size_t capacity;
+    static Retention retention;
+
+    // Tous les tampons créés, jamais libérés pour garder l'historique des
+    // threads terminés
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<Ring>> rings;
+};
+
+#endif // EVENTLOG_H
@@ -7,10 +7,19 @@
  */
 
 #include "extractor.h"
+#include <algorithm>
 #include "costs.h"
-#include <pcosynchro/pcothread.h>
-
-WindowInterface* Extractor::interface = nullptr;
+#include "eventlog.h"
+#include "checkpoint.h"
+#include "fundauditor.h"
+#include "journal.h"
+#include <cassert>
+#include "rng.h"
+#include "scheduler.h"
+
+SimulationSink* Extractor::interface = nullptr;
+DelayRange Extractor::miningTime = {10000U, 1000000U, 10000U};
+unsigned Extractor::crew = EXTRACTOR_MINERS;
 
 Extractor::Extractor(int uniqueId, int fund, ItemType resourceExtracted)
     : Seller(fund, uniqueId), resourceExtracted(resourceExtracted), nbExtracted(0)
@@ -18,63 +27,153 @@ Extractor::Extractor(int uniqueId, int fund, ItemType resourceExtracted)
     assert(resourceExtracted == ItemType::Copper ||
            resourceExtracted == ItemType::Sand ||
            resourceExtracted == ItemType::Petrol);
-    interface->consoleAppendText(uniqueId, QString("Mine Created"));
+    stocks.list(resourceExtracted);
+    publishStocks();
+    miners.reserve(crew);
+    INSTRUMENT(Instrumentation::add(uniqueId, "extractor", metrics, transactionMutex));
+    EventLog::record(uniqueId, EventCode::MineCreated);
     interface->updateFund(uniqueId, fund);
 }
 
-std::map<ItemType, int> Extractor::getItemsForSale() {
-    return stocks;
+StockLedger Extractor::listItemsForSale() {
+    return stocks.load();
 }
 
 int Extractor::trade(ItemType it, int qty) {
-    transactionMutex.lock();
-    if ( qty <= 0 || it != resourceExtracted || stocks[it] < qty) {
-        transactionMutex.unlock();
+    if (qty <= 0 || it != resourceExtracted) {
+        INSTRUMENT(metrics.fail(TradeFailure::Rejected));
         return 0;
     }
 
-    int cost = qty * getMaterialCost();
-    money += cost;
-    stocks[it] -= qty;
+    return sell(it, qty, getMaterialCost());
+}
+
+bool Extractor::tryTrade(ItemType it, int qty, int& bill) {
+    if (qty <= 0 || it != resourceExtracted) {
+        INSTRUMENT(metrics.fail(TradeFailure::Rejected));
+        bill = 0;
+        return true;
+    }
+
+    return trySell(it, qty, getMaterialCost(), bill);
+}
+
+bool Extractor::routineStart() {
+    EventLog::record(uniqueId, EventCode::MineStarted);
+    return true;
+}
 
+std::uint64_t Extractor::payMiners() {
+    int minerCost = getEmployeeSalary(getEmployeeThatProduces(resourceExtracted));
+    transactionMutex.lock();
+    std::uint64_t now = SimClock::now();
+    while (miners.size() < crew && money >= minerCost) {
+        /* On peut payer un mineur */
+        money -= minerCost;
+        FundAuditor::payWages(minerCost);
+        Journal::record(JournalKind::Wages, uniqueId, -1, resourceExtracted, 1, minerCost);
+        /* Statistiques, comptées dès le paiement pour que l'argent versé soit
+           toujours justifié, même si la routine s'arrête pendant le minage */
+        nbExtracted++;
+        /* Temps aléatoire borné qui simule le mineur qui mine */
+        miners.push_back(now + miningTime.draw());
+    }
+
+    std::uint64_t delay = NO_MINER;
+    if (!miners.empty()) {
+        std::uint64_t next = *std::min_element(miners.begin(), miners.end());
+        delay = next > now ? next - now : 0;
+    }
     transactionMutex.unlock();
-    return cost;
+    return delay;
+}
+
+void Extractor::creditMinedUnits() {
+    if (miners.empty()) {
+        return;
+    }
+
+    /* Incrément des stocks, une unité par mineur qui a terminé */
+    transactionMutex.lock();
+    std::uint64_t now = SimClock::now();
+    auto done = std::remove_if(miners.begin(), miners.end(),
+                               [now](std::uint64_t due) { return due <= now; });
+    int mined = static_cast<int>(miners.end() - done);
+    miners.erase(done, miners.end());
+    if (mined > 0) {
+        stocks.add(resourceExtracted, mined);
+        publishStocks();
+    }
+    transactionMutex.unlock();
+    if (mined == 0) {
+        return;
+    }
+    Journal::record(JournalKind::Produced, uniqueId, -1, resourceExtracted, mined, 0);
+
+    /* Message dans l'interface graphique */
+    for (int i = 0; i < mined; ++i) {
+        EventLog::record(uniqueId, EventCode::Mined, static_cast<int>(resourceExtracted));
+    }
+    /* Update de l'interface graphique */
+    interface->updateFund(uniqueId, money);
+    interface->updateStock(uniqueId, stocks.load());
 }
 
-void Extractor::run() {
-    interface->consoleAppendText(uniqueId, "[START] Mine routine");
+std::uint64_t Extractor::routineStep() {
+    creditMinedUnits();
 
-    while (!PcoThread::thisThread()->stopRequested()) {
-        int minerCost = getEmployeeSalary(getEmployeeThatProduces(resourceExtracted));
-        transactionMutex.lock();
-        if (money < minerCost) {
-            transactionMutex.unlock();
-            /* Pas assez d'argent */
-            /* Attend des jours meilleurs */
-            PcoThread::usleep(1000U);
+    std::uint64_t delay = payMiners();
+    if (delay == NO_MINER) {
+        /* Pas assez d'argent */
+        /* Attend qu'une vente rapporte de quoi payer un mineur */
+        return awaitFunds(getEmployeeSalary(getEmployeeThatProduces(resourceExtracted)));
+    }
+
+    /* Jusqu'à la fin du prochain minage */
+    return delay;
+}
+
+Routine Extractor::routine(AgentScheduler& scheduler) {
+    if (!routineStart()) {
+        co_return;
+    }
+
+    int minerCost = getEmployeeSalary(getEmployeeThatProduces(resourceExtracted));
+    while (!scheduler.stopRequested()) {
+        creditMinedUnits();
+
+        std::uint64_t delay = payMiners();
+        if (delay == NO_MINER) {
+            /* Attend qu'une vente rapporte de quoi payer un mineur */
+            co_await scheduler.funds(*this, minerCost);
             continue;
         }
 
-        /* On peut payer un mineur */
-        money -= minerCost;
-        transactionMutex.unlock();
-        /* Temps aléatoire borné qui simule le mineur qui mine */
-        PcoThread::usleep((rand() % 100 + 1) * 10000);
-        /* Statistiques */
-        nbExtracted++;
-        /* Incrément des stocks */
-        transactionMutex.lock();
-        stocks[resourceExtracted] += 1;
-        transactionMutex.unlock();
-
-        /* Message dans l'interface graphique */
-        interface->consoleAppendText(uniqueId, QString("1 ") % getItemName(resourceExtracted) %
-                                     " has been mined");
-        /* Update de l'interface graphique */
-        interface->updateFund(uniqueId, money);
-        interface->updateStock(uniqueId, &stocks);
+        /* Jusqu'à la fin du prochain minage */
+        co_await scheduler.sleep(delay);
     }
-    interface->consoleAppendText(uniqueId, "[STOP] Mine routine");
+
+    routineEnd();
+}
+
+void Extractor::routineEnd() {
+    EventLog::record(uniqueId, EventCode::MineStopped);
+}
+
+void Extractor::saveProgress(SellerState& state) {
+    state.kind = SellerKind::Extractor;
+    state.item = static_cast<std::uint8_t>(resourceExtracted);
+    state.paidWorkers = nbExtracted;
+    state.inProgress = static_cast<std::uint8_t>(miners.size());
+}
+
+void Extractor::restoreProgress(const SellerState& state) {
+    nbExtracted = state.paidWorkers;
+    // Les mineurs payés avant le point de reprise ont terminé leur travail
+    if (state.inProgress) {
+        stocks.add(resourceExtracted, state.inProgress);
+    }
+    miners.clear();
 }
 
 int Extractor::getMaterialCost() {
@@ -89,10 +188,28 @@ int Extractor::getAmountPaidToMiners() {
     return nbExtracted * getEmployeeSalary(getEmployeeThatProduces(resourceExtracted));
 }
 
-void Extractor::setInterface(WindowInterface *windowInterface) {
+void Extractor::setInterface(SimulationSink *windowInterface) {
     interface = windowInterface;
 }
 
+void Extractor::setMiningTime(DelayRange range) {
+    miningTime = range;
+}
+
+DelayRange Extractor::getMiningTime() {
+    return miningTime;
+}
+
+void Extractor::setMiners(unsigned nb) {
+    // Mineurs au travail comptés sur un octet dans les points de reprise
+    assert(nb > 0 && nb <= 255);
+    crew = nb;
+}
+
+unsigned Extractor::getMiners() {
+    return crew;
+}
+
 SandExtractor::SandExtractor(int uniqueId, int fund): Extractor::Extractor(uniqueId, fund, ItemType::Sand) {}
 
 CopperExtractor::CopperExtractor(int uniqueId, int fund): Extractor::Extractor(uniqueId, fund, ItemType::Copper) {}
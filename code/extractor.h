@@ -1,16 +1,36 @@
 #ifndef EXTRACTOR_H
 #define EXTRACTOR_H
 #include <QTimer>
-#include "windowinterface.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "simulationsink.h"
 #include "costs.h"
 #include "seller.h"
 
+// Mineurs qui travaillent en parallèle dans chaque mine, au plus
+#define EXTRACTOR_MINERS 1
+
 /**
  * @brief La classe offrant l'implémentation d'une mine et ces fonctions de ventes.
  */
 class Extractor : public Seller {
 public:
-    static void setInterface(WindowInterface* interface);
+    static void setInterface(SimulationSink* interface);
+
+    /**
+     * @brief Durée simulée du travail d'un mineur pour une unité
+     */
+    static void setMiningTime(DelayRange range);
+    static DelayRange getMiningTime();
+
+    /**
+     * @brief Taille maximale de l'équipe de mineurs de chaque mine
+     *        (EXTRACTOR_MINERS), de 1 à 255. Doit être appelé avant la
+     *        création des mines.
+     */
+    static void setMiners(unsigned nb);
+    static unsigned getMiners();
 
     /**
      * @brief Constructeur d'une mine
@@ -19,13 +39,16 @@ public:
      */
     Extractor(int uniqueId, int fund, ItemType resourceExtracted);
 
-    std::map<ItemType, int> getItemsForSale() override;
     int trade(ItemType it, int qty) override;
 
+    bool tryTrade(ItemType it, int qty, int& bill) override;
+
     /**
-     * @brief Routine de minage de ressources (fonction threadée)
+     * @brief Routine de minage en coroutine : attend les fonds pour payer un
+     *        mineur, attend la fin du prochain minage puis crédite les unités
+     *        minées.
      */
-    void run();
+    Routine routine(AgentScheduler& scheduler) override;
 
     /**
      * @brief Fonction permettant de savoir quelle ressources la mine possède
@@ -41,13 +64,53 @@ public:
 
     int getAmountPaidToMiners();
 
+protected:
+    StockLedger listItemsForSale() override;
+
+    bool routineStart() override;
+
+    /**
+     * @brief Étape de la routine de minage : crédite les unités des mineurs
+     *        qui ont terminé, paie autant de mineurs que les fonds et l'équipe
+     *        le permettent et rend le temps jusqu'à la fin du prochain minage.
+     */
+    std::uint64_t routineStep() override;
+
+    void routineEnd() override;
+
+    void saveProgress(SellerState& state) override;
+    void restoreProgress(const SellerState& state) override;
+
 private:
     // Identifiant du type de ressourcee miné
     const ItemType resourceExtracted;
-    // Compte le nombre d'employé payé
-    int nbExtracted;
+    // Compte le nombre d'employé payé, lu par d'autres threads (rapport final)
+    std::atomic<int> nbExtracted;
+    // Fin prévue (temps simulé) du travail de chaque mineur payé dont l'unité
+    // n'est pas encore créditée. Modifié sous transactionMutex par la seule
+    // routine de la mine.
+    std::vector<std::uint64_t> miners;
+
+    static SimulationSink* interface;
+    static DelayRange miningTime;
+    static unsigned crew;
+
+    // Retour de payMiners() quand aucun mineur ne travaille
+    static constexpr std::uint64_t NO_MINER = UINT64_MAX;
 
-    static WindowInterface* interface;
+    /**
+     * @brief Paie des mineurs tant que les fonds le permettent et que
+     *        l'équipe n'est pas complète
+     * @return Temps jusqu'à la fin du prochain minage, NO_MINER si aucun
+     *         mineur ne travaille
+     */
+    std::uint64_t payMiners();
+
+    /**
+     * @brief Ajoute au stock les unités des mineurs qui ont terminé et met à
+     *        jour l'interface
+     */
+    void creditMinedUnits();
 };
 
 
@@ -7,13 +7,24 @@
  */
 
 #include "factory.h"
-#include <pcosynchro/pcothread.h>
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include "costs.h"
+#include "eventlog.h"
+#include "checkpoint.h"
+#include "fundauditor.h"
+#include "journal.h"
 #include "extractor.h"
+#include "rng.h"
+#include "scheduler.h"
 #include "wholesale.h"
 
-WindowInterface* Factory::interface = nullptr;
+SimulationSink* Factory::interface = nullptr;
+DelayRange Factory::assemblyTime = {0U, 9900000U, 100000U};
+DelayRange Factory::orderPause = {1000000U, 1000000U};
+unsigned Factory::workers = FACTORY_WORKERS;
+unsigned Factory::capacity = FACTORY_CAPACITY;
 
 
 Factory::Factory(int uniqueId, int fund, ItemType builtItem,
@@ -25,16 +36,23 @@ Factory::Factory(int uniqueId, int fund, ItemType builtItem,
     assert(builtItem == ItemType::Chip || builtItem == ItemType::Plastic ||
            builtItem == ItemType::Robot);
 
+    // Les ressources nécessaires sont listées d'office pour orderResources()
+    for (ItemType item : resourcesNeeded) {
+        stocks.list(item);
+    }
+    publishStocks();
+    assemblies.reserve(workers);
+    INSTRUMENT(Instrumentation::add(uniqueId, "factory", metrics, transactionMutex));
+
     interface->updateFund(uniqueId, fund);
-    interface->consoleAppendText(uniqueId, "Factory created");
+    EventLog::record(uniqueId, EventCode::FactoryCreated);
 }
 
-void Factory::setWholesalers(std::vector<Wholesale*> wholesalers) {
+void Factory::setWholesalers(std::span<Wholesale* const> wholesalers,
+                             std::span<TradeFlows::Counter> flows) {
+    assert(flows.empty() || flows.size() == wholesalers.size());
     Factory::wholesalers = wholesalers;
-
-    for (Seller* seller : wholesalers) {
-        interface->setLink(uniqueId, seller->getUniqueId());
-    }
+    Factory::flows = flows;
 }
 
 ItemType Factory::getItemBuilt() {
@@ -47,7 +65,7 @@ int Factory::getMaterialCost() {
 
 bool Factory::verifyResources() {
     for (auto item : resourcesNeeded) {
-        if (stocks[item] == 0) {
+        if (stocks.get(item) == 0) {
             return false;
         }
     }
@@ -55,109 +73,269 @@ bool Factory::verifyResources() {
     return true;
 }
 
-void Factory::buildItem() {
+ItemType Factory::leastStockedResource() {
+    // Prioritizing resources the factory has the least of.
+    StockLedger current = stocks.load();
+    return (*std::min_element(current.cbegin(), current.cend(),
+                              [](const auto& l, const auto& r) {
+                                  return l.second < r.second;
+                              })).first;
+}
+
+std::uint64_t Factory::buildItems() {
     int salary = getEmployeeSalary(getEmployeeThatProduces(itemBuilt));
 
     transactionMutex.lock();
-    // If we have enough money to pay salary
-    if (money < salary) {
-        transactionMutex.unlock();
-        return;
-    }
+    std::uint64_t now = SimClock::now();
+    bool started = false;
+    // One item per idle worker, as long as its salary, its resources and
+    // room for its output are available
+    while (assemblies.size() < workers && money >= salary && verifyResources() &&
+           (capacity == 0 || std::size_t(stocks.get(itemBuilt)) + assemblies.size() < capacity)) {
+        // Reserve the resources of 1 item
+        for (ItemType item : resourcesNeeded) {
+            stocks.add(item, -1);
+        }
 
-    // Produce 1 item
-    for (ItemType item : resourcesNeeded) {
-        stocks[item]--;
+        // Pay salary
+        money -= salary;
+        FundAuditor::payWages(salary);
+        Journal::record(JournalKind::Wages, uniqueId, -1, itemBuilt, 1, salary);
+
+        // Increment number of payed employee as soon as the salary is paid
+        nbBuild++;
+        // Temps simulant l'assemblage d'un objet.
+        assemblies.push_back(now + assemblyTime.draw());
+        started = true;
+    }
+    if (started) {
+        publishStocks();
     }
 
-    // Pay salary
-    money -= salary;
+    std::uint64_t delay = NO_ASSEMBLY;
+    if (!assemblies.empty()) {
+        std::uint64_t next = *std::min_element(assemblies.begin(), assemblies.end());
+        delay = next > now ? next - now : 0;
+    }
     transactionMutex.unlock();
+    return delay;
+}
 
-    // Temps simulant l'assemblage d'un objet.
-    PcoThread::usleep((rand() % 100) * 100000);
-
-    // Increment number of payed employee
-    nbBuild++;
+void Factory::finishItems() {
+    if (assemblies.empty()) {
+        return;
+    }
 
     // update item stock
     transactionMutex.lock();
-    stocks[itemBuilt]++;
+    std::uint64_t now = SimClock::now();
+    auto done = std::remove_if(assemblies.begin(), assemblies.end(),
+                               [now](std::uint64_t due) { return due <= now; });
+    int built = static_cast<int>(assemblies.end() - done);
+    assemblies.erase(done, assemblies.end());
+    if (built > 0) {
+        stocks.add(itemBuilt, built);
+        publishStocks();
+    }
     transactionMutex.unlock();
+    if (built == 0) {
+        return;
+    }
+    Journal::record(JournalKind::Produced, uniqueId, -1, itemBuilt, built, 0);
 
     // Update interface
-    interface->consoleAppendText(uniqueId, "Factory have build a new object");
+    for (int i = 0; i < built; ++i) {
+        EventLog::record(uniqueId, EventCode::ItemBuilt);
+    }
 }
 
-void Factory::orderResources() {
+std::uint64_t Factory::orderResources() {
+    Checkpoint::TradeGuard guard;
+    if (!guard) {
+        // Point de reprise en cours, l'achat attendra la fin de la pause
+        return orderPause.draw();
+    }
+
     transactionMutex.lock();
-    // Prioritizing resources the factory has the least of.
-    ItemType resourceToBuy = std::min_element(stocks.cbegin(), stocks.cend(),
-                                              [](const auto& l, const auto& r) {
-                                                  return l.second < r.second;
-                                              })->first;
+    ItemType resourceToBuy = leastStockedResource();
 
     // Iterate over available wholesalers
-    for (Wholesale* ws : wholesalers) {
+    for (std::size_t link = 0; link < wholesalers.size(); ++link) {
+        Wholesale* ws = wholesalers[link];
         auto itemsForSale = ws->getItemsForSale();
-        if (itemsForSale.find(resourceToBuy) != itemsForSale.end()) {
+        if (itemsForSale.items.contains(resourceToBuy)) {
             int cost = getCostPerUnit(resourceToBuy);
-            if (cost > money)
+            if (cost > money) {
+                INSTRUMENT(metrics.fail(TradeFailure::Unaffordable));
                 break;
+            }
             cost = ws->trade(resourceToBuy, 1);
             if (cost == 0)
                 continue;  // Trade did not work. Look at another wholeseller.
-            stocks[resourceToBuy]++;
+            stocks.add(resourceToBuy);
             money -= cost;
+            FundAuditor::debit(cost);
+            Journal::record(JournalKind::Trade, uniqueId, ws->getUniqueId(), resourceToBuy, 1, cost);
+            if (!flows.empty()) {
+                TradeFlows::record(flows[link], 1);
+            }
             break;
         }
     }
     transactionMutex.unlock();
 
     // Temps de pause pour éviter trop de demande
-    PcoThread::usleep(10 * 100000);
+    return orderPause.draw();
 }
 
-void Factory::run() {
+bool Factory::routineStart() {
     if (wholesalers.empty()) {
         std::cerr << "You have to give to factories wholesalers to sales their "
                      "resources"
                   << std::endl;
-        return;
+        return false;
     }
-    interface->consoleAppendText(uniqueId, "[START] Factory routine");
+    EventLog::record(uniqueId, EventCode::FactoryStarted);
+    return true;
+}
 
-    while (!PcoThread::thisThread()->stopRequested()) {
-        if (verifyResources()) {
-            buildItem();
+std::uint64_t Factory::routineStep() {
+    finishItems();
+    std::uint64_t delay = buildItems();
+    if (assemblies.size() < workers && !verifyResources()) {
+        // Un employé attend des ressources
+        delay = std::min(delay, orderResources());
+    } else if (delay == NO_ASSEMBLY) {
+        int salary = getEmployeeSalary(getEmployeeThatProduces(itemBuilt));
+        if (money < salary) {
+            // Attend qu'une vente rapporte de quoi payer l'employé
+            delay = awaitFunds(salary);
         } else {
-            orderResources();
+            // Stock plein : seule une vente libère de la place, et elle nous crédite
+            delay = awaitFunds(money + 1);
+        }
+    }
+    interface->updateFund(uniqueId, money);
+    interface->updateStock(uniqueId, stocks.load());
+    return delay;
+}
+
+Routine Factory::routine(AgentScheduler& scheduler) {
+    if (!routineStart()) {
+        co_return;
+    }
+
+    int salary = getEmployeeSalary(getEmployeeThatProduces(itemBuilt));
+    while (!scheduler.stopRequested()) {
+        finishItems();
+        std::uint64_t delay = buildItems();
+        if (assemblies.size() >= workers) {
+            // Tous les employés sont occupés
+        } else if (verifyResources()) {
+            if (money < salary && assemblies.empty()) {
+                // Attend qu'une vente rapporte de quoi payer l'employé
+                co_await scheduler.funds(*this, salary);
+                continue;
+            }
+        } else {
+            // transactionMutex n'est pas gardé pendant l'achat : une routine
+            // peut reprendre sur un autre thread. L'usine étant seule à
+            // dépenser son argent, le contrôle préalable reste valable.
+            // Un point de reprise en cours reporte l'achat après la pause
+            if (Checkpoint::TradeGuard guard; guard) {
+                ItemType resourceToBuy = leastStockedResource();
+                for (std::size_t link = 0; link < wholesalers.size(); ++link) {
+                    Wholesale* ws = wholesalers[link];
+                    if (!ws->getItemsForSale().items.contains(resourceToBuy)) {
+                        continue;
+                    }
+                    if (getCostPerUnit(resourceToBuy) > money) {
+                        INSTRUMENT(metrics.fail(TradeFailure::Unaffordable));
+                        break;
+                    }
+                    int bill = 0;
+                    while (!co_await scheduler.trade(*ws, resourceToBuy, 1, bill)) {
+                        // Grossiste occupé, retenté après les autres routines
+                    }
+                    if (bill == 0) {
+                        continue;  // Trade did not work. Look at another wholeseller.
+                    }
+                    transactionMutex.lock();
+                    stocks.add(resourceToBuy);
+                    money -= bill;
+                    FundAuditor::debit(bill);
+                    transactionMutex.unlock();
+                    Journal::record(JournalKind::Trade, uniqueId, ws->getUniqueId(),
+                                    resourceToBuy, 1, bill);
+                    if (!flows.empty()) {
+                        TradeFlows::record(flows[link], 1);
+                    }
+                    break;
+                }
+            }
+
+            // Temps de pause pour éviter trop de demande
+            delay = std::min(delay, orderPause.draw());
         }
         interface->updateFund(uniqueId, money);
-        interface->updateStock(uniqueId, &stocks);
+        interface->updateStock(uniqueId, stocks.load());
+
+        if (delay == NO_ASSEMBLY) {
+            // Stock plein : seule une vente libère de la place, et elle nous crédite
+            co_await scheduler.funds(*this, money + 1);
+            continue;
+        }
+
+        // Jusqu'à la fin du prochain assemblage
+        co_await scheduler.sleep(delay);
     }
-    interface->consoleAppendText(uniqueId, "[STOP] Factory routine");
+
+    routineEnd();
+}
+
+void Factory::routineEnd() {
+    EventLog::record(uniqueId, EventCode::FactoryStopped);
 }
 
-std::map<ItemType, int> Factory::getItemsForSale() {
-    return std::map<ItemType, int>({
-        {itemBuilt, stocks[itemBuilt]}
-    });
+StockLedger Factory::listItemsForSale() {
+    StockLedger itemsForSale;
+    itemsForSale.set(itemBuilt, stocks.get(itemBuilt));
+    return itemsForSale;
 }
 
 int Factory::trade(ItemType it, int qty) {
-    transactionMutex.lock();
-    if (qty <= 0 || it != itemBuilt || stocks[it] < qty) {
-        transactionMutex.unlock();
+    if (qty <= 0 || it != itemBuilt) {
+        INSTRUMENT(metrics.fail(TradeFailure::Rejected));
         return 0;
     }
 
-    int cost = qty * getMaterialCost();
-    money += cost;
-    stocks[it] -= qty;
+    return sell(it, qty, getMaterialCost());
+}
 
-    transactionMutex.unlock();
-    return cost;
+bool Factory::tryTrade(ItemType it, int qty, int& bill) {
+    if (qty <= 0 || it != itemBuilt) {
+        INSTRUMENT(metrics.fail(TradeFailure::Rejected));
+        bill = 0;
+        return true;
+    }
+
+    return trySell(it, qty, getMaterialCost(), bill);
+}
+
+void Factory::saveProgress(SellerState& state) {
+    state.kind = SellerKind::Factory;
+    state.item = static_cast<std::uint8_t>(itemBuilt);
+    state.paidWorkers = nbBuild;
+    state.inProgress = static_cast<std::uint8_t>(assemblies.size());
+}
+
+void Factory::restoreProgress(const SellerState& state) {
+    nbBuild = state.paidWorkers;
+    // Les objets dont l'assemblage était payé sont terminés à la reprise
+    if (state.inProgress) {
+        stocks.add(itemBuilt, state.inProgress);
+    }
+    assemblies.clear();
 }
 
 int Factory::getAmountPaidToWorkers() {
@@ -165,10 +343,44 @@ int Factory::getAmountPaidToWorkers() {
            getEmployeeSalary(getEmployeeThatProduces(itemBuilt));
 }
 
-void Factory::setInterface(WindowInterface* windowInterface) {
+void Factory::setInterface(SimulationSink* windowInterface) {
     interface = windowInterface;
 }
 
+void Factory::setAssemblyTime(DelayRange range) {
+    assemblyTime = range;
+}
+
+void Factory::setOrderPause(DelayRange range) {
+    orderPause = range;
+}
+
+DelayRange Factory::getAssemblyTime() {
+    return assemblyTime;
+}
+
+DelayRange Factory::getOrderPause() {
+    return orderPause;
+}
+
+void Factory::setWorkers(unsigned nb) {
+    // Assemblages en cours comptés sur un octet dans les points de reprise
+    assert(nb > 0 && nb <= 255);
+    workers = nb;
+}
+
+void Factory::setCapacity(unsigned capacity) {
+    Factory::capacity = capacity;
+}
+
+unsigned Factory::getWorkers() {
+    return workers;
+}
+
+unsigned Factory::getCapacity() {
+    return capacity;
+}
+
 PlasticFactory::PlasticFactory(int uniqueId, int fund)
     : Factory::Factory(uniqueId, fund, ItemType::Plastic, {ItemType::Petrol}) {}
 
@@ -1,12 +1,21 @@
 #ifndef FACTORY_H
 #define FACTORY_H
+#include <atomic>
+#include <cstdint>
+#include <span>
 #include <vector>
-#include "windowinterface.h"
+#include "simulationsink.h"
 #include "seller.h"
+#include "tradeflows.h"
 #include <pcosynchro/pcomutex.h>
 
 class Wholesale;
 
+// Employés qui assemblent en parallèle dans chaque usine
+#define FACTORY_WORKERS 1
+// Stock maximal d'objets produits (assemblages en cours compris), 0 : illimité
+#define FACTORY_CAPACITY 0
+
 /**
  * @brief La classe permet l'implémentation d'une usine et de ces fonctions
  *        de ventes et d'achats.
@@ -22,14 +31,15 @@ public:
      */
     Factory(int uniqueId, int fund, ItemType builtItem, std::vector<ItemType> resourcesNeeded);
 
+    int trade(ItemType it, int number) override;
+
+    bool tryTrade(ItemType it, int number, int& bill) override;
+
     /**
-     * @brief Est la routine d'appel aux fonctions privée pour que l'usine fonctionne continuellement.
-     * fonction threadée
+     * @brief Routine de l'usine en coroutine : attend les fonds pour payer
+     *        l'employé, la fin de l'assemblage et celle des achats.
      */
-    void run();
-
-    std::map<ItemType, int> getItemsForSale() override;
-    int trade(ItemType it, int number) override;
+    Routine routine(AgentScheduler& scheduler) override;
 
     /**
      * @brief Permet d'accèder au coût du matériel produit par l'usine
@@ -45,25 +55,76 @@ public:
 
     /**
      * @brief Cette fonction permet d'affecter à une usine pluseurs grossistes pour pouvoir échanger avec eux.
-     * @param Vecteur de wholesaler
+     * @param Grossistes, doivent rester valides pendant toute la simulation
+     * @param Compteurs d'échanges, un par grossiste ou aucun
      */
-    void setWholesalers(std::vector<Wholesale*> wholesalers);
+    void setWholesalers(std::span<Wholesale* const> wholesalers,
+                        std::span<TradeFlows::Counter> flows = {});
 
     int getAmountPaidToWorkers();
 
-    static void setInterface(WindowInterface* windowInterface);
+    static void setInterface(SimulationSink* windowInterface);
+
+    /**
+     * @brief Durées simulées de l'assemblage d'un objet et de la pause qui
+     *        suit une commande de ressources
+     */
+    static void setAssemblyTime(DelayRange range);
+    static void setOrderPause(DelayRange range);
+    static DelayRange getAssemblyTime();
+    static DelayRange getOrderPause();
+
+    /**
+     * @brief Nombre d'employés de chaque usine et capacité de son stock
+     *        (FACTORY_WORKERS, FACTORY_CAPACITY). Doivent être appelés avant
+     *        la création des usines, de 1 à 255 employés.
+     */
+    static void setWorkers(unsigned nb);
+    static void setCapacity(unsigned capacity);
+    static unsigned getWorkers();
+    static unsigned getCapacity();
+
+protected:
+    StockLedger listItemsForSale() override;
+
+    bool routineStart() override;
+
+    /**
+     * @brief Étape de la routine de l'usine : termine les objets assemblés,
+     *        occupe les employés libres et commande les ressources qui leur
+     *        manquent.
+     */
+    std::uint64_t routineStep() override;
+
+    void routineEnd() override;
+
+    void saveProgress(SellerState& state) override;
+    void restoreProgress(const SellerState& state) override;
 
 private:
-    // Liste de grossiste auxquels l'usine peut acheter des ressources
-    std::vector<Wholesale*> wholesalers;
+    // Grossistes auxquels l'usine peut acheter des ressources, tranche de
+    // l'adjacence possédée par Utils
+    std::span<Wholesale* const> wholesalers;
+    // Compteurs des unités achetées à chaque grossiste, parallèles à wholesalers
+    std::span<TradeFlows::Counter> flows;
     // Liste de ressources voulus pour la production d'un objet
     const std::vector<ItemType> resourcesNeeded;
     // Identifiant de l'objet produit par l'usine, selon l'enum ItemType
     const ItemType itemBuilt;
-    // Compte le nombre d'employé payé
-    int nbBuild;
+    // Compte le nombre d'employé payé, lu par d'autres threads (rapport final)
+    std::atomic<int> nbBuild;
+    // Fin prévue (temps simulé) de chaque assemblage en cours, un par employé
+    // occupé. Modifié sous transactionMutex par la seule routine de l'usine.
+    std::vector<std::uint64_t> assemblies;
+
+    static SimulationSink* interface;
+    static DelayRange assemblyTime;
+    static DelayRange orderPause;
+    static unsigned workers;
+    static unsigned capacity;
 
-    static WindowInterface* interface;
+    // Retour de buildItems() quand aucun assemblage n'est en cours
+    static constexpr std::uint64_t NO_ASSEMBLY = UINT64_MAX;
 
     /**
      * @brief Fonction privée permettant de vérifier si l'usine à toute les ressources
@@ -72,15 +133,30 @@ private:
      */
     bool verifyResources();
 
+    /**
+     * @brief Ressource nécessaire dont l'usine a le moins en stock
+     */
+    ItemType leastStockedResource();
+
     /**
      * @brief Achat de ressources chez les grossistes (wholesalers)
+     * @return Temps de pause avant la prochaine étape
+     */
+    std::uint64_t orderResources();
+
+    /**
+     * @brief Occupe chaque employé libre : il réserve les ressources d'un
+     *        objet et reçoit son salaire d'un seul coup, sous transactionMutex,
+     *        tant que l'argent, les ressources et la capacité le permettent.
+     * @return Temps jusqu'à la fin du prochain assemblage, NO_ASSEMBLY si
+     *         aucun n'est en cours
      */
-    void orderResources();
+    std::uint64_t buildItems();
 
     /**
-     * @brief Construction d'un objet par l'usine.
+     * @brief Ajoute au stock les objets dont l'assemblage est terminé
      */
-    void buildItem();
+    void finishItems();
 };
 
 
@@ -0,0 +1,118 @@
+/**
+ * @file fundauditor.cpp
+ * @brief Implementation of the online money-conservation auditor
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "fundauditor.h"
+#include <QDebug>
+#include <chrono>
+#include "simclock.h"
+
+std::mutex FundAuditor::registryMutex;
+std::vector<std::unique_ptr<FundAuditor::Slot>> FundAuditor::ledgers;
+std::mutex FundAuditor::runMutex;
+std::condition_variable FundAuditor::wakeUp;
+bool FundAuditor::stopping = false;
+std::thread FundAuditor::auditor;
+std::atomic<std::uint64_t> FundAuditor::epoch{0};
+std::atomic<std::uint64_t> FundAuditor::firstBadEpoch{0};
+std::atomic<std::int64_t> FundAuditor::firstImbalance{0};
+
+FundAuditor::Ledger& FundAuditor::threadLedger() {
+    thread_local Ledger ledger;
+    if (!ledger.slot) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ledgers.push_back(std::make_unique<Slot>());
+        ledger.slot = ledgers.back().get();
+    }
+    return ledger;
+}
+
+void FundAuditor::publish(Ledger& ledger) {
+    ledger.slot->totals.store(ledger.totals);
+}
+
+void FundAuditor::credit(int amount) {
+    // Publié avec le débit, pour ne jamais montrer une vente à moitié faite
+    threadLedger().totals.credited += amount;
+}
+
+void FundAuditor::debit(int amount) {
+    Ledger& ledger = threadLedger();
+    ledger.totals.debited += amount;
+    publish(ledger);
+}
+
+void FundAuditor::payWages(int amount) {
+    Ledger& ledger = threadLedger();
+    ledger.totals.wages += amount;
+    publish(ledger);
+}
+
+FundAuditor::Totals FundAuditor::audit() {
+    Totals sum{};
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& slot : ledgers) {
+            Totals totals = slot->totals.load().value;
+            sum.credited += totals.credited;
+            sum.debited += totals.debited;
+            sum.wages += totals.wages;
+        }
+    }
+
+    std::uint64_t current = epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::int64_t imbalance = sum.credited - sum.debited;
+    std::uint64_t none = 0;
+    if (imbalance != 0 && firstBadEpoch.compare_exchange_strong(none, current)) {
+        firstImbalance = imbalance;
+        qWarning() << "Money" << (imbalance > 0 ? "created" : "lost") << "at audit epoch" << current
+                   << "(simulated time" << double(SimClock::now()) / 1e6 << "s) :"
+                   << sum.credited << "credited," << sum.debited << "debited";
+    }
+    return sum;
+}
+
+void FundAuditor::run(unsigned periodMs) {
+    std::unique_lock<std::mutex> lock(runMutex);
+    while (!wakeUp.wait_for(lock, std::chrono::milliseconds(periodMs), [] { return stopping; })) {
+        lock.unlock();
+        audit();
+        lock.lock();
+    }
+}
+
+void FundAuditor::start(unsigned periodMs) {
+    if (periodMs == 0 || auditor.joinable()) {
+        return;
+    }
+    stopping = false;
+    auditor = std::thread(&FundAuditor::run, periodMs);
+}
+
+FundAuditor::Totals FundAuditor::stop() {
+    if (auditor.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(runMutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        auditor.join();
+    }
+    return audit();
+}
+
+std::uint64_t FundAuditor::getEpoch() {
+    return epoch.load(std::memory_order_relaxed);
+}
+
+std::uint64_t FundAuditor::getFirstBadEpoch() {
+    return firstBadEpoch.load();
+}
+
+std::int64_t FundAuditor::getFirstImbalance() {
+    return firstImbalance.load();
+}
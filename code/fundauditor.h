@@ -0,0 +1,116 @@
+#ifndef FUNDAUDITOR_H
+#define FUNDAUDITOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "seqlock.h"
+
+// Période de contrôle de la conservation de l'argent en ms, 0 le désactive
+#define AUDIT_PERIOD_MS 1000
+
+/**
+ * @brief Contrôle continu de la conservation de l'argent, en partie double.
+ *
+ * Chaque mouvement d'argent est inscrit par le thread qui le fait : le crédit
+ * du vendeur (credit()), le débit de l'acheteur (debit()) et les salaires
+ * versés (payWages()). Une vente s'exécute entièrement sur le thread de
+ * l'acheteur, ses deux écritures sont donc publiées ensemble à la fin de la
+ * transaction, dans un compteur propre au thread et aligné sur une ligne de
+ * cache. Un thread publie ainsi toujours un état équilibré.
+ *
+ * Un thread d'audit additionne les compteurs à chaque époque sans rien
+ * bloquer : tant que la comptabilité est juste, crédits et débits sont égaux.
+ * La première époque où ils diffèrent (de l'argent créé ou perdu) est retenue.
+ */
+class FundAuditor {
+public:
+    /**
+     * @brief Totaux inscrits depuis le début de la simulation
+     */
+    struct Totals {
+        std::int64_t credited;
+        std::int64_t debited;
+        std::int64_t wages;
+    };
+
+    /**
+     * @brief Argent reçu par un vendeur, en attente du débit correspondant
+     */
+    static void credit(int amount);
+
+    /**
+     * @brief Argent payé par un acheteur, clôt la transaction
+     */
+    static void debit(int amount);
+
+    /**
+     * @brief Salaire versé, sort de la simulation
+     */
+    static void payWages(int amount);
+
+    /**
+     * @brief Lance les contrôles toutes les periodMs ms (0 n'en fait aucun)
+     */
+    static void start(unsigned periodMs);
+
+    /**
+     * @brief Arrête les contrôles après un dernier passage
+     * @return Les totaux de ce dernier passage
+     */
+    static Totals stop();
+
+    /**
+     * @brief Contrôle immédiat, renvoie les totaux publiés
+     */
+    static Totals audit();
+
+    /**
+     * @brief Nombre de contrôles effectués
+     */
+    static std::uint64_t getEpoch();
+
+    /**
+     * @brief Première époque déséquilibrée, 0 si aucune
+     */
+    static std::uint64_t getFirstBadEpoch();
+
+    /**
+     * @brief Crédits moins débits à la première époque déséquilibrée
+     */
+    static std::int64_t getFirstImbalance();
+
+private:
+    struct alignas(64) Slot {
+        SeqLock<Totals> totals;
+    };
+
+    struct Ledger {
+        Slot* slot = nullptr;
+        Totals totals{};
+    };
+
+    static Ledger& threadLedger();
+    static void publish(Ledger& ledger);
+    static void run(unsigned periodMs);
+
+    // Compteurs de tous les threads, jamais libérés pour garder ceux des
+    // threads terminés
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<Slot>> ledgers;
+
+    static std::mutex runMutex;
+    static std::condition_variable wakeUp;
+    static bool stopping;
+    static std::thread auditor;
+
+    static std::atomic<std::uint64_t> epoch;
+    static std::atomic<std::uint64_t> firstBadEpoch;
+    static std::atomic<std::int64_t> firstImbalance;
+};
+
+#endif // FUNDAUDITOR_H
@@ -0,0 +1,72 @@
+/**
+ * @file headless.cpp
+ * @brief Entry point of the simulation without any display
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "simulationsink.h"
+#include "utils.h"
+
+/**
+ * Usage : PCO_Labo_3_headless [--scenario=fichier] [--clé=valeur ...]
+ *                             [durée en secondes] [fichier de journal]
+ *
+ * Les options sont décrites dans scenario.h. Sans fichier de journal, toutes
+ * les notifications sont ignorées. Les événements des consoles gardés par
+ * EventLog et les unités échangées sur chaque lien sont écrits à la fin du
+ * journal.
+ */
+int main(int argc, char *argv[])
+{
+    Scenario scenario;
+    std::vector<std::string> arguments;
+    std::string error;
+    if (!scenario.parseArguments(argc, argv, arguments, error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int duration = arguments.size() > 0 ? std::atoi(arguments[0].c_str()) : 10;
+
+    std::unique_ptr<SimulationSink> sink;
+    FileSink* fileLog = nullptr;
+    if (arguments.size() > 1) {
+        auto fileSink = std::make_unique<FileSink>(arguments[1]);
+        if (!fileSink->isOpen()) {
+            std::cerr << "Cannot open " << arguments[1] << std::endl;
+            return EXIT_FAILURE;
+        }
+        fileLog = fileSink.get();
+        sink    = std::move(fileSink);
+    } else {
+        sink = std::make_unique<NullSink>();
+    }
+
+    Extractor::setInterface(sink.get());
+    Factory::setInterface(sink.get());
+    Wholesale::setInterface(sink.get());
+
+    configureSimulation(scenario);
+
+    Utils utils(scenario);
+    std::this_thread::sleep_for(std::chrono::seconds(duration));
+    utils.externalEndService();
+
+    if (fileLog) {
+        fileLog->writeEvents();
+        fileLog->writeFlows(utils.getTradeFlows());
+    }
+
+    std::cout << utils.getFinalReport().toStdString() << std::endl;
+    return EXIT_SUCCESS;
+}
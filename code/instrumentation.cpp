@@ -0,0 +1,276 @@
+/**
+ * @file instrumentation.cpp
+ * @brief Implementation of the lock and trade instrumentation
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "instrumentation.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t ns) {
+    ns = std::min<std::uint64_t>(ns, (std::uint64_t(1) << MAX_BITS) - 1);
+    if (ns < (2U << SUB_BITS)) {
+        return static_cast<std::size_t>(ns);
+    }
+    // Les SUB_BITS + 1 bits de poids fort choisissent la classe
+    unsigned shift = static_cast<unsigned>(std::bit_width(ns)) - SUB_BITS - 1;
+    return (std::size_t(shift) << SUB_BITS) + static_cast<std::size_t>(ns >> shift);
+}
+
+std::uint64_t LatencyHistogram::highestIn(std::size_t bucket) {
+    if (bucket < (2U << SUB_BITS)) {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>(bucket >> SUB_BITS) - 1;
+    std::uint64_t lowest = std::uint64_t(bucket - (std::size_t(shift) << SUB_BITS)) << shift;
+    return lowest + (std::uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t ns) {
+    buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+    std::uint64_t seen = maxNs.load(std::memory_order_relaxed);
+    while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const {
+    std::uint64_t count = this->count();
+    if (count == 0) {
+        return 0;
+    }
+
+    auto rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count)));
+    rank = std::clamp<std::uint64_t>(rank, 1, count);
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < NB_BUCKETS; ++bucket) {
+        seen += buckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(highestIn(bucket), max());
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (std::size_t bucket = 0; bucket < NB_BUCKETS; ++bucket) {
+        buckets[bucket].fetch_add(other.buckets[bucket].load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+    }
+    total.fetch_add(other.count(), std::memory_order_relaxed);
+    totalNs.fetch_add(other.sum(), std::memory_order_relaxed);
+
+    std::uint64_t otherMax = other.max();
+    std::uint64_t seen = maxNs.load(std::memory_order_relaxed);
+    while (otherMax > seen && !maxNs.compare_exchange_weak(seen, otherMax, std::memory_order_relaxed)) {
+    }
+}
+
+#ifdef PCO_INSTRUMENTATION
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Entry {
+    int id;
+    const char* kind;
+    const SellerMetrics* metrics;
+    std::span<const InstrumentedMutex> mutexes;
+};
+
+/**
+ * @brief Mesures cumulées des verrous d'un vendeur
+ */
+struct LockTotals {
+    LatencyHistogram wait;
+    LatencyHistogram hold;
+    std::uint64_t contentions = 0;
+};
+
+std::mutex registryMutex;
+std::vector<Entry> registry;
+
+const char* const failureNames[NB_TRADE_FAILURES] = {"rejected", "out_of_stock", "busy",
+                                                     "unaffordable"};
+
+const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+void writeJsonHistogram(std::ostream& out, const char* name, const LatencyHistogram& histogram) {
+    out << '"' << name << "\":{\"count\":" << histogram.count() << ",\"sum\":" << histogram.sum()
+        << ",\"p50\":" << histogram.percentile(0.5) << ",\"p90\":" << histogram.percentile(0.9)
+        << ",\"p99\":" << histogram.percentile(0.99) << ",\"p999\":" << histogram.percentile(0.999)
+        << ",\"max\":" << histogram.max() << '}';
+}
+
+/**
+ * Cumule les verrous de chaque vendeur inscrit, registryMutex étant pris
+ */
+std::vector<LockTotals> collectLocks() {
+    std::vector<LockTotals> totals(registry.size());
+    for (std::size_t i = 0; i < registry.size(); ++i) {
+        for (const InstrumentedMutex& mutex : registry[i].mutexes) {
+            totals[i].wait.merge(mutex.waitTimes());
+            totals[i].hold.merge(mutex.holdTimes());
+            totals[i].contentions += mutex.contentions();
+        }
+    }
+    return totals;
+}
+
+/**
+ * Un résumé Prometheus par histogramme : quantiles, somme et nombre
+ */
+template <typename Select>
+void writeSummary(std::ostream& out, const char* name, const char* help,
+                  const std::vector<Entry>& entries, Select select) {
+    out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << " summary\n";
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        const LatencyHistogram& histogram = select(i);
+        for (double q : quantiles) {
+            out << name << "{seller=\"" << entry.id << "\",kind=\"" << entry.kind
+                << "\",quantile=\"" << q << "\"} " << histogram.percentile(q) << '\n';
+        }
+        out << name << "_sum{seller=\"" << entry.id << "\",kind=\"" << entry.kind << "\"} "
+            << histogram.sum() << '\n';
+        out << name << "_count{seller=\"" << entry.id << "\",kind=\"" << entry.kind << "\"} "
+            << histogram.count() << '\n';
+    }
+}
+
+} // namespace
+
+void InstrumentedMutex::lock() {
+    if (!mutex.trylock()) {
+        contended.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t start = Instrumentation::now();
+        mutex.lock();
+        lockedAt = Instrumentation::now();
+        wait.record(lockedAt - start);
+        return;
+    }
+    lockedAt = Instrumentation::now();
+    wait.record(0);
+}
+
+void InstrumentedMutex::unlock() {
+    hold.record(Instrumentation::now() - lockedAt);
+    mutex.unlock();
+}
+
+bool InstrumentedMutex::trylock() {
+    if (!mutex.trylock()) {
+        contended.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    lockedAt = Instrumentation::now();
+    wait.record(0);
+    return true;
+}
+
+ScopedLatency::ScopedLatency(LatencyHistogram& histogram)
+    : histogram(histogram), start(Instrumentation::now()) {}
+
+ScopedLatency::~ScopedLatency() {
+    histogram.record(Instrumentation::now() - start);
+}
+
+std::uint64_t Instrumentation::now() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Instrumentation::add(int id, const char* kind, const SellerMetrics& metrics,
+                          const InstrumentedMutex& mutex) {
+    add(id, kind, metrics, std::span<const InstrumentedMutex>(&mutex, 1));
+}
+
+void Instrumentation::add(int id, const char* kind, const SellerMetrics& metrics,
+                          std::span<const InstrumentedMutex> mutexes) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back({id, kind, &metrics, mutexes});
+}
+
+void Instrumentation::remove(const SellerMetrics& metrics) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::erase_if(registry, [&metrics](const Entry& entry) { return entry.metrics == &metrics; });
+}
+
+void Instrumentation::writeJson(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<LockTotals> locks = collectLocks();
+    out << "{\"sellers\":[";
+    for (std::size_t i = 0; i < registry.size(); ++i) {
+        const Entry& entry = registry[i];
+        out << (i ? "," : "") << "\n{\"id\":" << entry.id << ",\"kind\":\"" << entry.kind << "\",";
+        writeJsonHistogram(out, "trade_latency_ns", entry.metrics->tradeLatency);
+        out << ',';
+        writeJsonHistogram(out, "lock_wait_ns", locks[i].wait);
+        out << ',';
+        writeJsonHistogram(out, "lock_hold_ns", locks[i].hold);
+        out << ",\"lock_contentions\":" << locks[i].contentions << ",\"failed_trades\":{";
+        for (std::size_t reason = 0; reason < NB_TRADE_FAILURES; ++reason) {
+            out << (reason ? "," : "") << '"' << failureNames[reason]
+                << "\":" << entry.metrics->failures[reason].load(std::memory_order_relaxed);
+        }
+        out << "}}";
+    }
+    out << "\n]}\n";
+}
+
+void Instrumentation::writePrometheus(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<LockTotals> locks = collectLocks();
+    writeSummary(out, "pco_trade_latency_ns", "Duration of a trade, lock wait included.", registry,
+                 [](std::size_t i) -> const LatencyHistogram& {
+                     return registry[i].metrics->tradeLatency;
+                 });
+    writeSummary(out, "pco_lock_wait_ns", "Time spent waiting for the seller's stock mutexes.",
+                 registry, [&locks](std::size_t i) -> const LatencyHistogram& {
+                     return locks[i].wait;
+                 });
+    writeSummary(out, "pco_lock_hold_ns", "Time the seller's stock mutexes were held.",
+                 registry, [&locks](std::size_t i) -> const LatencyHistogram& {
+                     return locks[i].hold;
+                 });
+
+    out << "# HELP pco_lock_contentions_total Lock attempts that found the mutex taken.\n"
+        << "# TYPE pco_lock_contentions_total counter\n";
+    for (std::size_t i = 0; i < registry.size(); ++i) {
+        out << "pco_lock_contentions_total{seller=\"" << registry[i].id << "\",kind=\""
+            << registry[i].kind << "\"} " << locks[i].contentions << '\n';
+    }
+
+    out << "# HELP pco_failed_trades_total Trades that did not happen, by reason.\n"
+        << "# TYPE pco_failed_trades_total counter\n";
+    for (const Entry& entry : registry) {
+        for (std::size_t reason = 0; reason < NB_TRADE_FAILURES; ++reason) {
+            out << "pco_failed_trades_total{seller=\"" << entry.id << "\",kind=\"" << entry.kind
+                << "\",reason=\"" << failureNames[reason] << "\"} "
+                << entry.metrics->failures[reason].load(std::memory_order_relaxed) << '\n';
+        }
+    }
+}
+
+bool Instrumentation::dump(const std::string& prefix) {
+    std::ofstream json(prefix + ".json");
+    std::ofstream prometheus(prefix + ".prom");
+    if (!json || !prometheus) {
+        return false;
+    }
+    writeJson(json);
+    writePrometheus(prometheus);
+    return bool(json) && bool(prometheus);
+}
+
+#endif // PCO_INSTRUMENTATION
@@ -0,0 +1,187 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <pcosynchro/pcomutex.h>
+
+/*
+ * Instrumentation des verrous et des ventes, activée à la compilation par
+ * PCO_INSTRUMENTATION (option CMake du même nom, DEFINES de qmake). Sans elle,
+ * INSTRUMENT() ne produit aucun code et InstrumentedMutex est un PcoMutex :
+ * rien n'est payé à l'exécution.
+ */
+#ifdef PCO_INSTRUMENTATION
+#define INSTRUMENT(statement) statement
+#else
+#define INSTRUMENT(statement)
+#endif
+
+/**
+ * @brief Raison de l'échec d'une vente
+ *
+ * Rejected : objet non vendu par le vendeur ou quantité invalide.
+ * OutOfStock : stock insuffisant.
+ * Busy : tryTrade() a renoncé, le verrou du vendeur était pris.
+ * Unaffordable : l'acheteur n'avait pas de quoi payer (compté chez l'acheteur).
+ */
+enum class TradeFailure { Rejected, OutOfStock, Busy, Unaffordable };
+
+constexpr std::size_t NB_TRADE_FAILURES = 4;
+
+/**
+ * @brief Histogramme de latences à la manière d'HdrHistogram : des classes
+ *        linéaires par puissance de deux, soit une précision relative de 3 %
+ *        sur toute la plage pour une taille fixe. Enregistrer une valeur ne
+ *        coûte que quelques additions atomiques.
+ *
+ * Toujours compilé : le banc d'essai tradebench s'en sert aussi.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @brief Enregistre une durée en nanosecondes
+     */
+    void record(std::uint64_t ns);
+
+    std::uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t sum() const { return totalNs.load(std::memory_order_relaxed); }
+    std::uint64_t max() const { return maxNs.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Plus petite durée telle qu'une proportion q des valeurs lui soit
+     *        inférieure ou égale, 0 <= q <= 1
+     */
+    std::uint64_t percentile(double q) const;
+
+    /**
+     * @brief Ajoute les valeurs d'un autre histogramme à celui-ci
+     */
+    void merge(const LatencyHistogram& other);
+
+private:
+    // 2^SUB_BITS classes par puissance de deux
+    static constexpr unsigned SUB_BITS = 5;
+    // Les durées au-delà (~68 s) sont comptées dans la dernière classe
+    static constexpr unsigned MAX_BITS = 36;
+    static constexpr std::size_t NB_BUCKETS = ((MAX_BITS - SUB_BITS - 1) << SUB_BITS) + (2U << SUB_BITS);
+
+    static std::size_t bucketOf(std::uint64_t ns);
+    static std::uint64_t highestIn(std::size_t bucket);
+
+    std::array<std::atomic<std::uint32_t>, NB_BUCKETS> buckets{};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> totalNs{0};
+    std::atomic<std::uint64_t> maxNs{0};
+};
+
+#ifdef PCO_INSTRUMENTATION
+
+#include <ostream>
+#include <span>
+#include <string>
+
+/**
+ * @brief PcoMutex qui mesure l'attente avant chaque prise et la durée de
+ *        chaque section critique
+ */
+class InstrumentedMutex {
+public:
+    void lock();
+    void unlock();
+    bool trylock();
+
+    const LatencyHistogram& waitTimes() const { return wait; }
+    const LatencyHistogram& holdTimes() const { return hold; }
+
+    /**
+     * @brief Nombre de prises qui ont dû attendre ou de trylock() refusés
+     */
+    std::uint64_t contentions() const { return contended.load(std::memory_order_relaxed); }
+
+private:
+    PcoMutex mutex;
+    // Écrit et lu par le seul détenteur du verrou
+    std::uint64_t lockedAt = 0;
+    LatencyHistogram wait;
+    LatencyHistogram hold;
+    std::atomic<std::uint64_t> contended{0};
+};
+
+/**
+ * @brief Mesures d'un vendeur
+ */
+struct SellerMetrics {
+    // Durée de chaque vente, attente du verrou comprise
+    LatencyHistogram tradeLatency;
+    std::array<std::atomic<std::uint64_t>, NB_TRADE_FAILURES> failures{};
+
+    void fail(TradeFailure reason) {
+        failures[static_cast<std::size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Mesure la durée d'une portée et l'enregistre à sa sortie
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram);
+    ~ScopedLatency();
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram& histogram;
+    std::uint64_t start;
+};
+
+/**
+ * @brief Registre des vendeurs mesurés et export des mesures
+ */
+class Instrumentation {
+public:
+    /**
+     * @brief Temps monotone en nanosecondes
+     */
+    static std::uint64_t now();
+
+    /**
+     * @brief Inscrit un vendeur, ses mesures doivent vivre jusqu'à remove()
+     */
+    static void add(int id, const char* kind, const SellerMetrics& metrics,
+                    const InstrumentedMutex& mutex);
+
+    /**
+     * @brief Inscrit un vendeur qui protège son stock par plusieurs verrous,
+     *        leurs mesures sont cumulées
+     */
+    static void add(int id, const char* kind, const SellerMetrics& metrics,
+                    std::span<const InstrumentedMutex> mutexes);
+
+    static void remove(const SellerMetrics& metrics);
+
+    static void writeJson(std::ostream& out);
+
+    /**
+     * @brief Format texte de Prometheus (exposition 0.0.4)
+     */
+    static void writePrometheus(std::ostream& out);
+
+    /**
+     * @brief Écrit prefix.json et prefix.prom
+     * @return false si un fichier n'a pas pu être écrit
+     */
+    static bool dump(const std::string& prefix);
+};
+
+#else
+
+using InstrumentedMutex = PcoMutex;
+
+#endif // PCO_INSTRUMENTATION
+
+#endif // INSTRUMENTATION_H
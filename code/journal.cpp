@@ -0,0 +1,208 @@
+/**
+ * @file journal.cpp
+ * @brief Implementation of the memory-mapped transaction journal
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "journal.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "simclock.h"
+
+namespace {
+
+constexpr char MAGIC[8] = {'P', 'C', 'O', 'J', 'R', 'N', 'L', '\0'};
+constexpr std::size_t CHUNK_BYTES = JOURNAL_CHUNK_RECORDS * sizeof(JournalRecord);
+
+} // namespace
+
+std::atomic<bool> Journal::enabled{false};
+std::atomic<std::uint64_t> Journal::sequence{0};
+std::atomic<unsigned> Journal::generation{0};
+std::string Journal::prefix;
+std::mutex Journal::registryMutex;
+std::vector<std::unique_ptr<Journal::Segment>> Journal::segments;
+
+std::string Journal::segmentPath(const std::string& prefix, std::size_t segment) {
+    return prefix + "." + std::to_string(segment) + ".journal";
+}
+
+bool Journal::open(const std::string& journalPrefix) {
+    close();
+    if (journalPrefix.empty()) {
+        return false;
+    }
+
+    // Les segments d'un journal précédent fausseraient load()
+    for (std::size_t n = 0; ::unlink(segmentPath(journalPrefix, n).c_str()) == 0; ++n) {
+    }
+
+    prefix = journalPrefix;
+    sequence = 0;
+    ++generation;
+    enabled = true;
+    return true;
+}
+
+std::uint64_t Journal::close() {
+    enabled = false;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::uint64_t total = 0;
+    for (auto& segment : segments) {
+        if (segment->chunks.empty()) {
+            if (segment->fd >= 0) {
+                ::close(segment->fd);
+            }
+            continue;
+        }
+        auto* header = reinterpret_cast<JournalHeader*>(segment->chunks.front());
+        header->records = segment->used - 1;
+        total += header->records;
+
+        for (JournalRecord* chunk : segment->chunks) {
+            ::munmap(chunk, CHUNK_BYTES);
+        }
+        // Retire la fin inutilisée du dernier agrandissement
+        if (::ftruncate(segment->fd, static_cast<off_t>(segment->used * sizeof(JournalRecord))) != 0) {
+            qWarning() << "Cannot trim journal segment" << segment->index;
+        }
+        ::close(segment->fd);
+    }
+    segments.clear();
+    return total;
+}
+
+Journal::Segment* Journal::threadSegment() {
+    struct Binding {
+        Segment* segment = nullptr;
+        unsigned generation = 0;
+    };
+    thread_local Binding binding;
+
+    unsigned current = generation.load(std::memory_order_relaxed);
+    if (binding.generation != current) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto segment = std::make_unique<Segment>();
+        segment->index = static_cast<std::uint32_t>(segments.size());
+        segment->fd = ::open(segmentPath(prefix, segment->index).c_str(),
+                             O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (segment->fd < 0) {
+            qWarning() << "Cannot create journal segment" << segment->index;
+        }
+        segments.push_back(std::move(segment));
+        binding = {segments.back().get(), current};
+    }
+    return binding.segment;
+}
+
+bool Journal::grow(Segment& segment) {
+    if (segment.fd < 0) {
+        return false;
+    }
+
+    auto offset = static_cast<off_t>(segment.chunks.size() * CHUNK_BYTES);
+    if (::ftruncate(segment.fd, offset + static_cast<off_t>(CHUNK_BYTES)) != 0) {
+        return false;
+    }
+    void* chunk = ::mmap(nullptr, CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd, offset);
+    if (chunk == MAP_FAILED) {
+        return false;
+    }
+    segment.chunks.push_back(static_cast<JournalRecord*>(chunk));
+
+    if (segment.chunks.size() == 1) {
+        JournalHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.recordSize = sizeof(JournalRecord);
+        header.segment = segment.index;
+        std::memcpy(chunk, &header, sizeof(header));
+        segment.used = 1;
+    }
+    return true;
+}
+
+void Journal::record(JournalKind kind, int entity, int counterpart, ItemType item, int qty,
+                     int amount) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    Segment* segment = threadSegment();
+    if (segment->used == segment->chunks.size() * JOURNAL_CHUNK_RECORDS && !grow(*segment)) {
+        // Disque plein ou segment inutilisable : l'enregistrement est perdu
+        return;
+    }
+
+    JournalRecord& slot = segment->chunks[segment->used / JOURNAL_CHUNK_RECORDS]
+                                         [segment->used % JOURNAL_CHUNK_RECORDS];
+    slot = {sequence.fetch_add(1, std::memory_order_relaxed) + 1,
+            SimClock::now(),
+            entity,
+            counterpart,
+            amount,
+            static_cast<std::int16_t>(qty),
+            static_cast<std::uint8_t>(item),
+            kind};
+    ++segment->used;
+}
+
+std::vector<JournalRecord> Journal::load(const std::string& journalPrefix) {
+    std::vector<JournalRecord> records;
+
+    for (std::size_t n = 0;; ++n) {
+        int fd = ::open(segmentPath(journalPrefix, n).c_str(), O_RDONLY);
+        if (fd < 0) {
+            break;
+        }
+
+        struct stat info {};
+        std::size_t size = ::fstat(fd, &info) == 0 ? static_cast<std::size_t>(info.st_size) : 0;
+        void* data = size >= sizeof(JournalHeader)
+                         ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                         : MAP_FAILED;
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            qWarning() << "Cannot read journal segment" << n;
+            continue;
+        }
+
+        const auto* header = static_cast<const JournalHeader*>(data);
+        if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+            header->recordSize != sizeof(JournalRecord)) {
+            qWarning() << "Journal segment" << n << "has an unknown format";
+            ::munmap(data, size);
+            continue;
+        }
+
+        const auto* first = static_cast<const JournalRecord*>(data) + 1;
+        std::size_t available = size / sizeof(JournalRecord) - 1;
+        std::size_t count = header->records;
+        if (count == 0 || count > available) {
+            // Segment non fermé : il s'arrête au premier enregistrement vide
+            count = 0;
+            while (count < available && first[count].sequence != 0) {
+                ++count;
+            }
+        }
+
+        // Chaque segment est déjà trié, il suffit de le fusionner aux autres
+        auto middle = static_cast<std::ptrdiff_t>(records.size());
+        records.insert(records.end(), first, first + count);
+        std::inplace_merge(records.begin(), records.begin() + middle, records.end(),
+                           [](const JournalRecord& l, const JournalRecord& r) {
+                               return l.sequence < r.sequence;
+                           });
+        ::munmap(data, size);
+    }
+
+    return records;
+}
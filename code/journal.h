@@ -0,0 +1,135 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "stockledger.h"
+
+// Enregistrements ajoutés à un segment à chaque agrandissement (1 Mio)
+#define JOURNAL_CHUNK_RECORDS 32768
+
+/**
+ * @brief Nature d'une transaction du journal
+ */
+enum class JournalKind : std::uint8_t {
+    Trade,      // entity achète qty item à counterpart pour amount
+    Wages,      // entity verse amount de salaire pour produire item
+    Produced    // entity ajoute qty item à son stock
+};
+
+/**
+ * @brief Enregistrement binaire de taille fixe, tel qu'écrit dans le fichier
+ */
+struct JournalRecord {
+    // Ordre global, à partir de 1 ; 0 marque la fin d'un segment
+    std::uint64_t sequence;
+    // Temps simulé (voir SimClock)
+    std::uint64_t time;
+    std::int32_t entity;
+    std::int32_t counterpart;
+    std::int32_t amount;
+    std::int16_t qty;
+    // ItemType
+    std::uint8_t item;
+    JournalKind kind;
+};
+
+static_assert(sizeof(JournalRecord) == 32, "the journal file format is 32 bytes per record");
+
+/**
+ * @brief En-tête d'un segment, occupe la place du premier enregistrement
+ */
+struct JournalHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t segment;
+    std::uint32_t reserved;
+    // Nombre d'enregistrements, écrit à la fermeture (0 si le programme
+    // s'est arrêté avant : le segment se termine alors au premier trou)
+    std::uint64_t records;
+};
+
+static_assert(sizeof(JournalHeader) == sizeof(JournalRecord));
+
+/**
+ * @brief Journal des transactions en ajout seul, dans des fichiers projetés
+ *        en mémoire.
+ *
+ * Chaque vente, chaque salaire et chaque production est inscrit par le
+ * thread qui le fait, dans son propre segment (prefix.<n>.journal) : écrire
+ * un enregistrement ne prend aucun verrou ni appel système, le segment n'est
+ * agrandi que tous les JOURNAL_CHUNK_RECORDS enregistrements. Un numéro de
+ * séquence global, tiré d'un compteur atomique, ordonne les enregistrements
+ * de tous les segments ; load() les fusionne selon cet ordre.
+ *
+ * Les pages projetées survivent à un arrêt brutal du programme, ce qui permet
+ * l'analyse après coup d'une exécution interrompue.
+ */
+class Journal {
+public:
+    static constexpr std::uint32_t VERSION = 1;
+
+    /**
+     * @brief Ouvre un journal neuf, ses segments seront prefix.<n>.journal.
+     *        Doit être appelé avant le lancement des threads.
+     * @return false si prefix est vide (journal désactivé)
+     */
+    static bool open(const std::string& prefix);
+
+    /**
+     * @brief Termine les segments et les libère, une fois tous les threads
+     *        arrêtés
+     * @return Nombre d'enregistrements écrits
+     */
+    static std::uint64_t close();
+
+    static bool isOpen() { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Inscrit une transaction dans le segment du thread appelant, ne
+     *        fait rien si le journal est fermé
+     */
+    static void record(JournalKind kind, int entity, int counterpart, ItemType item, int qty,
+                       int amount);
+
+    /**
+     * @brief Relit tous les segments d'un journal
+     * @return Les enregistrements de tous les segments, dans l'ordre global
+     */
+    static std::vector<JournalRecord> load(const std::string& prefix);
+
+    /**
+     * @brief Nom du fichier d'un segment
+     */
+    static std::string segmentPath(const std::string& prefix, std::size_t segment);
+
+private:
+    struct Segment {
+        int fd = -1;
+        std::uint32_t index = 0;
+        // Projections successives du fichier, une par agrandissement
+        std::vector<JournalRecord*> chunks;
+        // Enregistrements écrits, en-tête compris
+        std::size_t used = 0;
+    };
+
+    static Segment* threadSegment();
+    static bool grow(Segment& segment);
+
+    static std::atomic<bool> enabled;
+    static std::atomic<std::uint64_t> sequence;
+    // Change à chaque open(), invalide les segments gardés par les threads
+    static std::atomic<unsigned> generation;
+    static std::string prefix;
+
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<Segment>> segments;
+};
+
+#endif // JOURNAL_H
@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <cstdlib>
 
 #include "utils.h"
 #include "windowinterface.h"
@@ -7,16 +8,28 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // Scénario par défaut, remplacé par --scenario=fichier et --clé=valeur
+    Scenario scenario;
+    std::vector<std::string> arguments;
+    std::string error;
+    if (!scenario.parseArguments(argc, argv, arguments, error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
     //Création du vecteur de thread
 
-    WindowInterface::initialize(NB_EXTRACTOR, NB_FACTORIES, NB_WHOLESALER);
+    WindowInterface::initialize(scenario.extractorTypes(), scenario.factoryTypes(), scenario.nbWholesalers);
     auto interface = new WindowInterface();
 
     Extractor::setInterface(interface);
     Factory::setInterface(interface);
     Wholesale::setInterface(interface);
 
-    Utils utils = Utils(NB_EXTRACTOR, NB_FACTORIES, NB_WHOLESALER);
+    configureSimulation(scenario);
+
+    Utils utils = Utils(scenario);
     interface->setUtils(&utils);
 
     return a.exec();
@@ -1,41 +1,62 @@
 #include "mainwindow.h"
 
+#include <QScrollBar>
+#include <QVBoxLayout>
 #include "utils.h"
 
 #define CONSOLE_MINIMUM_WIDTH 200
+// Nombre d'événements gardés par la console, toutes entités confondues
+#define CONSOLE_CAPACITY 100000
 
-MainWindow::MainWindow(unsigned int nbMines, unsigned int nbFactories, unsigned int nbWholesalers, QWidget * parent) :
+MainWindow::MainWindow(const std::vector<ItemType>& mines, const std::vector<ItemType>& factories,
+                       unsigned int nbWholesalers, QWidget * parent) :
     QMainWindow(parent)
 {
-    m_nbConsoles = nbMines + nbFactories + nbWholesalers;
-    m_consoles = std::vector<QTextEdit*>(m_nbConsoles);
+    m_nbConsoles = static_cast<unsigned int>(mines.size() + factories.size()) + nbWholesalers;
 //    m_button = new QPushButton("Quit simulation", this);
 ////    m_button->setGeometry(QRect(QPoint(500, 500), QSize(200, 50)));
 //    m_button->show();
 
 //    connect(m_button, &QPushButton::released, this, &MainWindow::handleButton);
 
-    for (unsigned int i = 0; i < m_nbConsoles; ++i) {
-        m_consoles[i] = new QTextEdit(this);
-        m_consoles[i]->setMinimumWidth(CONSOLE_MINIMUM_WIDTH);
-    }
-
-    m_docks = std::vector<QDockWidget*>(m_nbConsoles);
+    // Une seule console : la vue ne crée des lignes que pour la partie
+    // visible, quel que soit le nombre d'entités
+    m_console = new ConsoleModel(CONSOLE_CAPACITY, this);
 
-    for (unsigned int i = 0; i < m_nbConsoles; ++i){
-        m_docks[i] = new QDockWidget(this);
-        m_docks[i]->setWidget(m_consoles[i]);
+    m_consoleFilter = new QComboBox;
+    m_consoleFilter->addItem("All entities", ConsoleModel::ALL_ENTITIES);
+    unsigned int id = 0;
+    for (ItemType item : mines) {
+        m_consoleFilter->addItem(QString("%1 - %2 mine").arg(id).arg(getItemName(item)), id);
+        ++id;
     }
-
-    for(unsigned int i = 0; i < m_nbConsoles/2; i++) {
-        this->addDockWidget(Qt::LeftDockWidgetArea, m_docks[i]);
+    for (unsigned int i = 0; i < nbWholesalers; ++i) {
+        m_consoleFilter->addItem(QString("%1 - Wholesaler").arg(id), id);
+        ++id;
     }
-
-    for(unsigned int i = m_nbConsoles/2; i < m_nbConsoles; i++) {
-        this->addDockWidget(Qt::RightDockWidgetArea, m_docks[i]);
+    for (ItemType item : factories) {
+        m_consoleFilter->addItem(QString("%1 - %2 factory").arg(id).arg(getItemName(item)), id);
+        ++id;
     }
+    connect(m_consoleFilter, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::selectConsole);
+
+    m_consoleView = new QListView;
+    m_consoleView->setModel(m_console);
+    m_consoleView->setUniformItemSizes(true);
+    m_consoleView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_consoleView->setMinimumWidth(CONSOLE_MINIMUM_WIDTH);
+
+    QWidget *console = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(console);
+    layout->addWidget(m_consoleFilter);
+    layout->addWidget(m_consoleView);
 
-    display = new Display(nbMines, nbFactories, nbWholesalers, this);
+    m_consoleDock = new QDockWidget("Console", this);
+    m_consoleDock->setWidget(console);
+    this->addDockWidget(Qt::RightDockWidgetArea, m_consoleDock);
+
+    display = new Display(mines, factories, nbWholesalers, this);
     setCentralWidget(display);
 }
 
@@ -48,26 +69,31 @@ MainWindow::MainWindow(unsigned int nbMines, unsigned int nbFactories, unsigned
 void MainWindow::setUtils(Utils* utils)
 {
     this->utils = utils;
+    display->setTradeFlows(&utils->getTradeFlows());
 }
 
-void MainWindow::consoleAppendText(unsigned int consoleId, const QString &text){
-    if(consoleId >= m_nbConsoles){
-        return;
+void MainWindow::consoleAppendEvents(const std::vector<Event>& events){
+    QScrollBar *scrollBar = m_consoleView->verticalScrollBar();
+    bool following = scrollBar->value() == scrollBar->maximum();
+
+    m_console->append(events);
+
+    if (following) {
+        m_consoleView->scrollToBottom();
     }
+}
 
-    m_consoles[consoleId]->append(text);
+void MainWindow::selectConsole(int index){
+    m_console->setFilter(m_consoleFilter->itemData(index).toInt());
+    m_consoleView->scrollToBottom();
 }
 
-void MainWindow::updateStock(unsigned int id, std::map<ItemType, int>* stocks){
+void MainWindow::updateStock(unsigned int id, const StockLedger& stocks){
     display->update_stocks(id, stocks);
 }
 
 void MainWindow::updateFund(unsigned int id, unsigned new_fund){
-    display->update_fund(id, QString::number(new_fund));
-}
-
-void MainWindow::set_link(int from, int to){
-    display->set_link(from, to);
+    display->update_fund(id, new_fund);
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
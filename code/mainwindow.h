@@ -1,10 +1,12 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "consolemodel.h"
 #include "display.h"
 
 #include <QMainWindow>
-#include <QTextEdit>
+#include <QComboBox>
+#include <QListView>
 #include <QDockWidget>
 #include <iostream>
 #include <QCloseEvent>
@@ -15,27 +17,36 @@ class Utils;
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
-    MainWindow(unsigned int nbMines, unsigned int nbFactories, unsigned int nbWholesalers, QWidget * parent = 0);
+    MainWindow(const std::vector<ItemType>& mines, const std::vector<ItemType>& factories,
+               unsigned int nbWholesalers, QWidget * parent = 0);
 //    ~MainWindow();
 
     Display * display;
-    std::vector<QTextEdit* > m_consoles;
-    std::vector<QDockWidget*> m_docks;
-//    std::vector<QTextBlock* > m_docks;
     void setUtils(Utils* utils);
 
 protected:
     unsigned int m_nbConsoles;
+    // Console unique, filtrée par entité
+    ConsoleModel *m_console;
+    QListView *m_consoleView;
+    QComboBox *m_consoleFilter;
+    QDockWidget *m_consoleDock;
     void closeEvent(QCloseEvent *event);
     Utils *utils;
 
 public slots:
-    void consoleAppendText(unsigned int consoleId, const QString& text);
+    /**
+     * @brief Ajoute les événements à la console, la vue suit la fin du
+     *        journal tant qu'elle y est déjà
+     */
+    void consoleAppendEvents(const std::vector<Event>& events);
 //    void handleButton();
 
     void updateFund(unsigned int id, unsigned new_fund);
-    void updateStock(unsigned int id, std::map<ItemType, int>* stocks);
-    void set_link(int from, int to);
+    void updateStock(unsigned int id, const StockLedger& stocks);
+private slots:
+    void selectConsole(int index);
+
 private:
 //    QPushButton *m_button;
 };
@@ -0,0 +1,140 @@
+/**
+ * @file rng.cpp
+ * @brief Implementation of the per-thread random number service
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "rng.h"
+#include <atomic>
+#include <cassert>
+#include <random>
+#include <utility>
+
+namespace {
+
+__extension__ typedef unsigned __int128 uint128;
+
+std::uint64_t splitmix64(std::uint64_t& x) {
+    std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Flux attribué au générateur propre de chaque thread, hors des flux stables
+// de forStream()
+std::atomic<std::uint64_t> nextAnonymousStream{1ULL << 32};
+
+struct ThreadGenerator {
+    ThreadGenerator()
+        : generator(Rng::getMasterSeed() ^ nextAnonymousStream.fetch_add(1)) {}
+
+    Xoshiro256 generator;
+};
+
+thread_local ThreadGenerator threadGenerator;
+thread_local Xoshiro256* boundGenerator = nullptr;
+
+} // namespace
+
+void Xoshiro256::reseed(std::uint64_t seed) {
+    for (auto& word : state) {
+        word = splitmix64(seed);
+    }
+}
+
+std::uint64_t Rng::masterSeed = std::random_device{}();
+
+void Rng::setMasterSeed(std::uint64_t seed) {
+    masterSeed = seed ? seed : std::random_device{}();
+}
+
+std::uint64_t Rng::getMasterSeed() {
+    return masterSeed;
+}
+
+Xoshiro256 Rng::forStream(std::uint64_t stream) {
+    std::uint64_t mix = stream;
+    return Xoshiro256(masterSeed ^ splitmix64(mix));
+}
+
+Xoshiro256* Rng::bind(Xoshiro256* generator) {
+    return std::exchange(boundGenerator, generator);
+}
+
+Xoshiro256& Rng::generator() {
+    return boundGenerator ? *boundGenerator : threadGenerator.generator;
+}
+
+std::uint64_t Rng::below(std::uint64_t bound) {
+    assert(bound > 0);
+    // Méthode de Lemire : multiplication 128 bits et rejet du reste biaisé
+    Xoshiro256& gen = generator();
+    uint128 product = static_cast<uint128>(gen()) * bound;
+    auto low = static_cast<std::uint64_t>(product);
+    if (low < bound) {
+        const std::uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = static_cast<uint128>(gen()) * bound;
+            low     = static_cast<std::uint64_t>(product);
+        }
+    }
+    return static_cast<std::uint64_t>(product >> 64);
+}
+
+int Rng::between(int min, int max) {
+    assert(min <= max);
+    auto span = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min) + 1;
+    return static_cast<int>(min + static_cast<std::int64_t>(below(span)));
+}
+
+double Rng::uniform() {
+    return static_cast<double>(generator()() >> 11) * 0x1.0p-53;
+}
+
+AliasTable::AliasTable(const std::vector<double>& weights)
+    : probabilities(weights.size(), 0.0), aliases(weights.size(), 0) {
+    const std::size_t n = weights.size();
+    double total = 0.0;
+    for (double w : weights) {
+        assert(w >= 0.0);
+        total += w;
+    }
+    assert(n > 0 && total > 0.0);
+
+    std::vector<double> scaled(n);
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    for (std::size_t i = 0; i < n; ++i) {
+        scaled[i] = weights[i] * static_cast<double>(n) / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        std::size_t less = small.back();
+        std::size_t more = large.back();
+        small.pop_back();
+        large.pop_back();
+
+        probabilities[less] = scaled[less];
+        aliases[less]       = more;
+        scaled[more]        = scaled[more] + scaled[less] - 1.0;
+        (scaled[more] < 1.0 ? small : large).push_back(more);
+    }
+
+    // Le reste vaut 1 aux erreurs d'arrondi près
+    for (std::size_t i : large) {
+        probabilities[i] = 1.0;
+    }
+    for (std::size_t i : small) {
+        probabilities[i] = 1.0;
+    }
+}
+
+std::size_t AliasTable::sample() const {
+    assert(!probabilities.empty());
+    std::size_t column = static_cast<std::size_t>(Rng::below(probabilities.size()));
+    return Rng::uniform() < probabilities[column] ? column : aliases[column];
+}
@@ -0,0 +1,127 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Générateur xoshiro256** : 32 octets d'état, quelques cycles par tirage.
+ *        Satisfait UniformRandomBitGenerator et peut donc servir avec <random>.
+ */
+class Xoshiro256 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256(std::uint64_t seed = 0) { reseed(seed); }
+
+    /**
+     * @brief Réinitialise l'état à partir d'une graine via splitmix64
+     */
+    void reseed(std::uint64_t seed);
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const std::uint64_t t      = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t state[4];
+};
+
+/**
+ * @brief Service de nombres aléatoires, un générateur par thread.
+ *
+ * Tous les générateurs dérivent d'une unique graine maître : un générateur
+ * obtenu par forStream() avec un identifiant stable (ex: l'uniqueId d'un
+ * vendeur) tire toujours la même suite d'une exécution à l'autre. Un agent
+ * qui possède son propre générateur le lie au thread qui l'exécute avec
+ * bind(), ce qui garde ses tirages reproductibles même s'il change de thread.
+ * Aucun appel système ni verrou global n'est pris lors d'un tirage.
+ */
+class Rng {
+public:
+    /**
+     * @brief Fixe la graine maître. 0 choisit une graine aléatoire.
+     *        Doit être appelé avant le lancement des threads.
+     */
+    static void setMasterSeed(std::uint64_t seed);
+
+    static std::uint64_t getMasterSeed();
+
+    /**
+     * @brief Crée un générateur indépendant pour le flux stream
+     */
+    static Xoshiro256 forStream(std::uint64_t stream);
+
+    /**
+     * @brief Fait utiliser generator par les tirages du thread appelant,
+     *        nullptr rétablit le générateur propre au thread
+     * @return Le générateur lié jusque-là, à relier après un usage temporaire
+     */
+    static Xoshiro256* bind(Xoshiro256* generator);
+
+    /**
+     * @brief Générateur utilisé par le thread appelant
+     */
+    static Xoshiro256& generator();
+
+    /**
+     * @brief Entier uniforme dans [0, bound[, sans biais
+     */
+    static std::uint64_t below(std::uint64_t bound);
+
+    /**
+     * @brief Entier uniforme dans [min, max]
+     */
+    static int between(int min, int max);
+
+    /**
+     * @brief Réel uniforme dans [0, 1[
+     */
+    static double uniform();
+
+private:
+    static std::uint64_t masterSeed;
+};
+
+/**
+ * @brief Table d'alias de Vose : tirage pondéré en O(1) après une
+ *        construction en O(n).
+ */
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    /**
+     * @brief Construit la table, les poids doivent être positifs ou nuls et
+     *        au moins l'un d'eux strictement positif
+     */
+    explicit AliasTable(const std::vector<double>& weights);
+
+    /**
+     * @brief Tire un indice proportionnellement à son poids
+     */
+    std::size_t sample() const;
+
+    std::size_t size() const { return probabilities.size(); }
+
+private:
+    std::vector<double> probabilities;
+    std::vector<std::size_t> aliases;
+};
+
+#endif // RNG_H
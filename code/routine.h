@@ -0,0 +1,68 @@
+#ifndef ROUTINE_H
+#define ROUTINE_H
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+class AgentScheduler;
+class Seller;
+struct RoutinePromise;
+
+/**
+ * @brief Routine d'un vendeur écrite comme une coroutine C++20.
+ *
+ * La coroutine démarre suspendue et est confiée à un AgentScheduler qui la
+ * reprend sur l'un de ses ouvriers. Elle ne coûte que son cadre (quelques
+ * centaines d'octets) au lieu d'une pile de thread, et ses attentes (temps,
+ * fonds, ventes) sont des co_await qui rendent la main à l'ordonnanceur.
+ */
+class Routine {
+public:
+    using promise_type = RoutinePromise;
+    using Handle       = std::coroutine_handle<RoutinePromise>;
+
+    explicit Routine(Handle handle) : handle(handle) {}
+
+    Routine(Routine&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    Routine(const Routine&)            = delete;
+    Routine& operator=(const Routine&) = delete;
+
+    ~Routine() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /**
+     * @brief Cède la coroutine, le nouveau propriétaire doit la détruire
+     */
+    Handle release() { return std::exchange(handle, {}); }
+
+private:
+    Handle handle;
+};
+
+struct RoutinePromise {
+    // Vendeur dont c'est la routine et ordonnanceur qui la reprend
+    Seller* agent             = nullptr;
+    AgentScheduler* scheduler = nullptr;
+
+    /**
+     * @brief Signale la fin de la routine à l'ordonnanceur, qui détruit le cadre
+     */
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<RoutinePromise> handle) noexcept;
+        void await_resume() noexcept {}
+    };
+
+    Routine get_return_object() { return Routine(Routine::Handle::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+};
+
+#endif // ROUTINE_H
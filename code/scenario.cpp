@@ -0,0 +1,426 @@
+/**
+ * @file scenario.cpp
+ * @brief Implementation of the runtime scenario configuration
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "scenario.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include "extractor.h"
+#include "factory.h"
+#include "wholesale.h"
+
+namespace {
+
+const std::pair<const char*, ItemType> itemNames[] = {
+    {"sand", ItemType::Sand},   {"copper", ItemType::Copper},   {"petrol", ItemType::Petrol},
+    {"chip", ItemType::Chip},   {"plastic", ItemType::Plastic}, {"robot", ItemType::Robot}};
+
+const std::pair<const char*, EmployeeType> employeeNames[] = {
+    {"extractor", EmployeeType::Extractor},     {"electrician", EmployeeType::Electrician},
+    {"plasturgist", EmployeeType::Plasturgist}, {"engineer", EmployeeType::Engineer}};
+
+std::string trim(const std::string& text) {
+    auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return {};
+    }
+    auto last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+template<typename T>
+bool parseNumber(const std::string& text, T& value) {
+    const char* last = text.data() + text.size();
+    auto result = std::from_chars(text.data(), last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+bool parseItem(const std::string& text, ItemType& item) {
+    for (const auto& [name, type] : itemNames) {
+        if (text == name) {
+            item = type;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Durée "n" ou "min..max" ou "min..max/pas"
+ */
+bool parseDelay(const std::string& text, DelayRange& range) {
+    DelayRange parsed{0, 0, 1};
+    std::string bounds = text;
+
+    auto slash = text.find('/');
+    if (slash != std::string::npos) {
+        if (!parseNumber(trim(text.substr(slash + 1)), parsed.step) || parsed.step == 0) {
+            return false;
+        }
+        bounds = text.substr(0, slash);
+    }
+
+    auto dots = bounds.find("..");
+    if (dots == std::string::npos) {
+        if (!parseNumber(trim(bounds), parsed.min)) {
+            return false;
+        }
+        parsed.max = parsed.min;
+    } else if (!parseNumber(trim(bounds.substr(0, dots)), parsed.min) ||
+               !parseNumber(trim(bounds.substr(dots + 2)), parsed.max) ||
+               parsed.max < parsed.min) {
+        return false;
+    }
+
+    range = parsed;
+    return true;
+}
+
+/**
+ * Mélange "type:poids, type:poids", le poids vaut 1 s'il est omis
+ */
+bool parseMix(const std::string& text, const std::vector<ItemType>& allowed, Scenario::Mix& mix) {
+    Scenario::Mix parsed;
+    unsigned total = 0;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        auto comma = text.find(',', start);
+        std::string entry = trim(text.substr(start, comma == std::string::npos ? std::string::npos
+                                                                               : comma - start));
+        start = comma == std::string::npos ? text.size() + 1 : comma + 1;
+
+        unsigned weight = 1;
+        auto colon = entry.find(':');
+        if (colon != std::string::npos) {
+            if (!parseNumber(trim(entry.substr(colon + 1)), weight)) {
+                return false;
+            }
+            entry = trim(entry.substr(0, colon));
+        }
+
+        ItemType item;
+        if (!parseItem(lower(entry), item) ||
+            std::find(allowed.begin(), allowed.end(), item) == allowed.end()) {
+            return false;
+        }
+        parsed.emplace_back(item, weight);
+        total += weight;
+    }
+
+    if (total == 0) {
+        return false;
+    }
+    mix = std::move(parsed);
+    return true;
+}
+
+/**
+ * Répartition déterministe de count entités selon les poids du mélange
+ * (tourniquet pondéré lissé) : à poids égaux, on retrouve l'alternance i % n.
+ */
+std::vector<ItemType> assignTypes(unsigned count, const Scenario::Mix& mix) {
+    std::vector<ItemType> types;
+    types.reserve(count);
+
+    long long total = 0;
+    for (const auto& entry : mix) {
+        total += entry.second;
+    }
+
+    std::vector<long long> current(mix.size(), 0);
+    for (unsigned i = 0; i < count; ++i) {
+        std::size_t chosen = 0;
+        for (std::size_t j = 0; j < mix.size(); ++j) {
+            current[j] += mix[j].second;
+            if (current[j] > current[chosen]) {
+                chosen = j;
+            }
+        }
+        current[chosen] -= total;
+        types.push_back(mix[chosen].first);
+    }
+
+    return types;
+}
+
+} // namespace
+
+Scenario::Scenario()
+    : nbExtractors(NB_EXTRACTOR),
+      nbFactories(NB_FACTORIES),
+      nbWholesalers(NB_WHOLESALER),
+      extractorMix{{ItemType::Sand, 1}, {ItemType::Copper, 1}, {ItemType::Petrol, 1}},
+      factoryMix{{ItemType::Plastic, 1}, {ItemType::Chip, 1}, {ItemType::Robot, 1}},
+      extractorFund(EXTRACTOR_FUND),
+      factoryFund(FACTORIES_FUND),
+      wholesalerFund(WHOLESALERS_FUND),
+      extractorMiners(Extractor::getMiners()),
+      factoryWorkers(Factory::getWorkers()),
+      factoryCapacity(Factory::getCapacity()),
+      miningTime(Extractor::getMiningTime()),
+      assemblyTime(Factory::getAssemblyTime()),
+      orderPause(Factory::getOrderPause()),
+      purchasePause(Wholesale::getPurchasePause()),
+      tradeMode(TRADE_MODE),
+      seed(RNG_SEED),
+      clockMode(CLOCK_MODE),
+      clockSpeed(CLOCK_SPEED),
+      executionMode(EXECUTION_MODE),
+      nbWorkers(NB_WORKERS),
+      logCapacity(EventLog::getCapacity()),
+      logRetention(EventLog::getRetention()),
+      auditPeriod(AUDIT_PERIOD_MS),
+      checkpointPeriod(CHECKPOINT_PERIOD_MS) {
+    for (std::size_t i = 0; i < NB_ITEM_TYPES; ++i) {
+        prices[i] = getCostPerUnit(static_cast<ItemType>(i));
+    }
+    for (std::size_t i = 0; i < NB_EMPLOYEE_TYPES; ++i) {
+        salaries[i] = getEmployeeSalary(static_cast<EmployeeType>(i));
+    }
+}
+
+bool Scenario::loadFile(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "Cannot open scenario " + path;
+        return false;
+    }
+
+    std::string line;
+    for (unsigned number = 1; std::getline(file, line); ++number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        auto equal = line.find('=');
+        if (equal == std::string::npos) {
+            error = path + ":" + std::to_string(number) + ": expected key = value";
+            return false;
+        }
+        if (!set(trim(line.substr(0, equal)), trim(line.substr(equal + 1)), error)) {
+            error = path + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Scenario::set(const std::string& key, const std::string& rawValue, std::string& error) {
+    const std::string value = lower(trim(rawValue));
+    bool valid = false;
+
+    if ((key == "extractors" || key == "factories" || key == "wholesalers") &&
+        !restoreFile.empty()) {
+        error = key + " is fixed by the checkpoint " + restoreFile;
+        return false;
+    } else if (key == "extractors") {
+        valid = parseNumber(value, nbExtractors) && nbExtractors > 0;
+    } else if (key == "factories") {
+        valid = parseNumber(value, nbFactories) && nbFactories > 0;
+    } else if (key == "wholesalers") {
+        valid = parseNumber(value, nbWholesalers) && nbWholesalers > 0;
+    } else if (key == "extractors.mix") {
+        valid = parseMix(value, {ItemType::Sand, ItemType::Copper, ItemType::Petrol}, extractorMix);
+    } else if (key == "factories.mix") {
+        valid = parseMix(value, {ItemType::Plastic, ItemType::Chip, ItemType::Robot}, factoryMix);
+    } else if (key == "extractors.fund") {
+        valid = parseNumber(value, extractorFund) && extractorFund >= 0;
+    } else if (key == "factories.fund") {
+        valid = parseNumber(value, factoryFund) && factoryFund >= 0;
+    } else if (key == "wholesalers.fund") {
+        valid = parseNumber(value, wholesalerFund) && wholesalerFund >= 0;
+    } else if (key == "extractors.miners") {
+        // Compté sur un octet dans les points de reprise
+        valid = parseNumber(value, extractorMiners) && extractorMiners > 0 && extractorMiners <= 255;
+    } else if (key == "factories.workers") {
+        // Compté sur un octet dans les points de reprise
+        valid = parseNumber(value, factoryWorkers) && factoryWorkers > 0 && factoryWorkers <= 255;
+    } else if (key == "factories.capacity") {
+        valid = parseNumber(value, factoryCapacity);
+    } else if (key.rfind("price.", 0) == 0) {
+        ItemType item;
+        valid = parseItem(key.substr(6), item) &&
+                parseNumber(value, prices[static_cast<std::size_t>(item)]);
+    } else if (key.rfind("salary.", 0) == 0) {
+        for (const auto& [name, employee] : employeeNames) {
+            if (key.substr(7) == name) {
+                valid = parseNumber(value, salaries[static_cast<std::size_t>(employee)]);
+            }
+        }
+    } else if (key == "time.mining") {
+        valid = parseDelay(value, miningTime);
+    } else if (key == "time.assembly") {
+        valid = parseDelay(value, assemblyTime);
+    } else if (key == "time.order") {
+        valid = parseDelay(value, orderPause);
+    } else if (key == "time.purchase") {
+        valid = parseDelay(value, purchasePause);
+    } else if (key == "topology") {
+        const std::pair<const char*, TopologyKind> kinds[] = {
+            {"sliced", TopologyKind::Sliced},       {"full", TopologyKind::Full},
+            {"regional", TopologyKind::Regional},   {"fanout", TopologyKind::BoundedFanOut},
+            {"scalefree", TopologyKind::ScaleFree}, {"regular", TopologyKind::RandomRegular}};
+        for (const auto& [name, kind] : kinds) {
+            if (value == name) {
+                topology.kind = kind;
+                valid = true;
+            }
+        }
+    } else if (key == "topology.regions") {
+        valid = parseNumber(value, topology.regions) && topology.regions > 0;
+    } else if (key == "topology.degree") {
+        valid = parseNumber(value, topology.degree) && topology.degree > 0;
+    } else if (key == "topology.seed") {
+        valid = parseNumber(value, topology.seed);
+    } else if (key == "trade.mode") {
+        valid = value == "locked" || value == "lockfree";
+        if (valid) {
+            tradeMode = value == "lockfree" ? TradeMode::LockFree : TradeMode::Locked;
+        }
+    } else if (key == "seed") {
+        valid = parseNumber(value, seed);
+    } else if (key == "clock.mode") {
+        valid = value == "realtime" || value == "scaled" || value == "afap";
+        if (valid) {
+            clockMode = value == "afap"     ? ClockMode::AsFastAsPossible
+                        : value == "scaled" ? ClockMode::Scaled
+                                            : ClockMode::RealTime;
+        }
+    } else if (key == "clock.speed") {
+        valid = parseNumber(value, clockSpeed) && clockSpeed > 0.0;
+    } else if (key == "execution") {
+        valid = value == "threads" || value == "workstealing" || value == "coroutines";
+        if (valid) {
+            executionMode = value == "coroutines"     ? ExecutionMode::Coroutines
+                            : value == "workstealing" ? ExecutionMode::WorkStealing
+                                                      : ExecutionMode::Threads;
+        }
+    } else if (key == "workers") {
+        valid = parseNumber(value, nbWorkers);
+    } else if (key == "log.capacity") {
+        valid = parseNumber(value, logCapacity);
+    } else if (key == "log.retention") {
+        valid = value == "latest" || value == "oldest";
+        if (valid) {
+            logRetention = value == "oldest" ? EventLog::Retention::KeepOldest
+                                             : EventLog::Retention::KeepLatest;
+        }
+    } else if (key == "audit.period") {
+        valid = parseNumber(value, auditPeriod);
+    } else if (key == "metrics.file") {
+        // Chemin de fichier : la casse est gardée
+        metricsFile = trim(rawValue);
+        valid = true;
+    } else if (key == "journal.file") {
+        journalFile = trim(rawValue);
+        valid = true;
+    } else if (key == "checkpoint.file") {
+        checkpointFile = trim(rawValue);
+        valid = true;
+    } else if (key == "checkpoint.period") {
+        valid = parseNumber(value, checkpointPeriod);
+    } else if (key == "restore.file") {
+        return loadCheckpoint(trim(rawValue), error);
+    } else {
+        error = "unknown key " + key;
+        return false;
+    }
+
+    if (!valid) {
+        error = "invalid value \"" + rawValue + "\" for " + key;
+    }
+    return valid;
+}
+
+bool Scenario::parseArguments(int argc, char* argv[], std::vector<std::string>& positional,
+                              std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0) {
+            positional.push_back(argument);
+            continue;
+        }
+
+        auto equal = argument.find('=');
+        if (equal == std::string::npos) {
+            error = "expected --key=value, got " + argument;
+            return false;
+        }
+        std::string key   = argument.substr(2, equal - 2);
+        std::string value = argument.substr(equal + 1);
+
+        if (key == "scenario" ? !loadFile(value, error) : !set(key, value, error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Scenario::loadCheckpoint(const std::string& path, std::string& error) {
+    CheckpointImage image;
+    if (!image.open(path, error)) {
+        return false;
+    }
+
+    const CheckpointHeader& header = image.header();
+    nbExtractors  = header.nbExtractors;
+    nbWholesalers = header.nbWholesalers;
+    nbFactories   = header.nbFactories;
+
+    restoredExtractorTypes.clear();
+    restoredFactoryTypes.clear();
+    for (const SellerState& state : image.sellers()) {
+        if (state.kind == SellerKind::Extractor) {
+            restoredExtractorTypes.push_back(static_cast<ItemType>(state.item));
+        } else if (state.kind == SellerKind::Factory) {
+            restoredFactoryTypes.push_back(static_cast<ItemType>(state.item));
+        }
+    }
+    if (restoredExtractorTypes.size() != nbExtractors || restoredFactoryTypes.size() != nbFactories) {
+        error = path + " does not match its header";
+        return false;
+    }
+
+    restoredStartFund = header.startFund;
+    restoreFile = path;
+    return true;
+}
+
+std::vector<ItemType> Scenario::extractorTypes() const {
+    if (!restoreFile.empty()) {
+        return restoredExtractorTypes;
+    }
+    return assignTypes(nbExtractors, extractorMix);
+}
+
+std::vector<ItemType> Scenario::factoryTypes() const {
+    if (!restoreFile.empty()) {
+        return restoredFactoryTypes;
+    }
+    return assignTypes(nbFactories, factoryMix);
+}
+
+long long Scenario::startFund() const {
+    // Les fonds d'une simulation reprise sont ceux de la simulation d'origine
+    if (!restoreFile.empty()) {
+        return restoredStartFund;
+    }
+    return static_cast<long long>(extractorFund) * nbExtractors +
+           static_cast<long long>(factoryFund) * nbFactories +
+           static_cast<long long>(wholesalerFund) * nbWholesalers;
+}
@@ -0,0 +1,189 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "checkpoint.h"
+#include "eventlog.h"
+#include "fundauditor.h"
+#include "scheduler.h"
+#include "seller.h"
+#include "simclock.h"
+#include "topology.h"
+
+// Valeurs par défaut du scénario
+#define NB_EXTRACTOR 3
+#define NB_FACTORIES 3
+#define NB_WHOLESALER 2
+#define EXTRACTOR_FUND 200
+#define FACTORIES_FUND 300
+#define WHOLESALERS_FUND 250
+#define TRADE_MODE TradeMode::Locked
+// Graine maître des générateurs aléatoires, 0 pour une graine aléatoire
+#define RNG_SEED 0
+// Mode de l'horloge simulée et facteur d'accélération (mode Scaled)
+#define CLOCK_MODE ClockMode::RealTime
+#define CLOCK_SPEED 1.0
+// Exécution des routines : un thread par vendeur, ou ordonnanceur à vol de
+// tâches (étapes ou coroutines) avec NB_WORKERS threads (0 pour un par coeur)
+#define EXECUTION_MODE ExecutionMode::Threads
+#define NB_WORKERS 0
+
+/**
+ * @brief Description d'une simulation, chargée au démarrage.
+ *
+ * Les valeurs par défaut sont celles des macros de utils.h et costs.h. Un
+ * fichier de scénario puis les options de la ligne de commande les remplacent,
+ * ce qui permet de changer d'échelle sans recompiler. Le fichier contient une
+ * affectation "clé = valeur" par ligne, # commence un commentaire :
+ *
+ *   extractors = 12
+ *   extractors.mix = sand:2, copper:1, petrol:1
+ *   factories.fund = 500
+ *   price.robot = 20
+ *   salary.engineer = 9
+ *   time.mining = 10000..1000000/10000
+ *   clock.mode = afap
+ *
+ * Clés reconnues :
+ *   extractors, factories, wholesalers        nombre d'entités
+ *   extractors.mix, factories.mix             types et poids ("type:poids, ...")
+ *   extractors.fund, factories.fund, wholesalers.fund
+ *   extractors.miners                         mineurs en parallèle par mine, au plus (1 à 255)
+ *   factories.workers                         assemblages en parallèle par usine (1 à 255)
+ *   factories.capacity                        stock maximal d'objets produits, 0 : illimité
+ *   price.<objet>                             sand, copper, petrol, chip, plastic, robot
+ *   salary.<employé>                          extractor, electrician, plasturgist, engineer
+ *   time.mining, time.assembly, time.order, time.purchase
+ *                                             µs simulées, "n" ou "min..max[/pas]"
+ *   topology                                  sliced, full, regional, fanout,
+ *                                             scalefree, regular
+ *   topology.regions, topology.degree, topology.seed
+ *   trade.mode                                locked, lockfree
+ *   seed                                      0 pour une graine aléatoire
+ *   clock.mode, clock.speed                   realtime, scaled, afap
+ *   execution, workers                        threads, workstealing, coroutines
+ *   log.capacity                              événements gardés par thread, 0 désactive
+ *   log.retention                             latest, oldest (quand le tampon est plein)
+ *   audit.period                              ms entre deux contrôles des fonds, 0 désactive
+ *   metrics.file                              préfixe des mesures .json et .prom écrites en
+ *                                             fin de simulation (builds PCO_INSTRUMENTATION)
+ *   journal.file                              préfixe des segments du journal des
+ *                                             transactions, vide le désactive
+ *   checkpoint.file, checkpoint.period        point de reprise écrit en fin de simulation
+ *                                             et toutes les n ms (0 : seulement à la fin)
+ *   restore.file                              reprend la simulation d'un point de reprise,
+ *                                             qui fixe alors le nombre et le type des entités
+ */
+struct Scenario {
+    /**
+     * @brief Type d'entité et son poids dans le mélange
+     */
+    using Mix = std::vector<std::pair<ItemType, unsigned>>;
+
+    unsigned nbExtractors;
+    unsigned nbFactories;
+    unsigned nbWholesalers;
+
+    Mix extractorMix;
+    Mix factoryMix;
+
+    int extractorFund;
+    int factoryFund;
+    int wholesalerFund;
+
+    unsigned extractorMiners;
+    unsigned factoryWorkers;
+    unsigned factoryCapacity;
+
+    // Prix unitaires indexés par ItemType, salaires indexés par EmployeeType
+    std::array<int, NB_ITEM_TYPES> prices;
+    std::array<int, NB_EMPLOYEE_TYPES> salaries;
+
+    DelayRange miningTime;
+    DelayRange assemblyTime;
+    DelayRange orderPause;
+    DelayRange purchasePause;
+
+    TopologyOptions topology;
+
+    TradeMode tradeMode;
+    std::uint64_t seed;
+    ClockMode clockMode;
+    double clockSpeed;
+    ExecutionMode executionMode;
+    unsigned nbWorkers;
+
+    std::size_t logCapacity;
+    EventLog::Retention logRetention;
+
+    unsigned auditPeriod;
+
+    // Vide : aucune mesure écrite
+    std::string metricsFile;
+
+    // Vide : aucun journal des transactions
+    std::string journalFile;
+
+    // Vide : aucun point de reprise
+    std::string checkpointFile;
+    unsigned checkpointPeriod;
+
+    // Vide : simulation neuve
+    std::string restoreFile;
+    // Relus du point de reprise
+    std::vector<ItemType> restoredExtractorTypes;
+    std::vector<ItemType> restoredFactoryTypes;
+    long long restoredStartFund = 0;
+
+    /**
+     * @brief Scénario par défaut, identique aux macros
+     */
+    Scenario();
+
+    /**
+     * @brief Applique un fichier de scénario
+     * @return false en cas d'erreur, décrite dans error
+     */
+    bool loadFile(const std::string& path, std::string& error);
+
+    /**
+     * @brief Remplace une valeur
+     * @return false si la clé est inconnue ou la valeur invalide
+     */
+    bool set(const std::string& key, const std::string& value, std::string& error);
+
+    /**
+     * @brief Applique la ligne de commande : --scenario=fichier charge un
+     *        fichier, --clé=valeur remplace une valeur, dans l'ordre donné.
+     * @param positional Reçoit les autres arguments, dans leur ordre
+     */
+    bool parseArguments(int argc, char* argv[], std::vector<std::string>& positional,
+                        std::string& error);
+
+    /**
+     * @brief Ressource minée par chaque mine, dans l'ordre de création
+     */
+    std::vector<ItemType> extractorTypes() const;
+
+    /**
+     * @brief Objet produit par chaque usine, dans l'ordre de création
+     */
+    std::vector<ItemType> factoryTypes() const;
+
+    /**
+     * @brief Somme des fonds initiaux de toutes les entités
+     */
+    long long startFund() const;
+
+private:
+    /**
+     * @brief Relit le nombre et le type des entités d'un point de reprise
+     */
+    bool loadCheckpoint(const std::string& path, std::string& error);
+};
+
+#endif // SCENARIO_H
@@ -0,0 +1,273 @@
+/**
+ * @file scheduler.cpp
+ * @brief Implementation of the work-stealing agent scheduler
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "scheduler.h"
+#include <algorithm>
+#include "seller.h"
+#include "simclock.h"
+
+namespace {
+
+// Ordonnanceur et file de l'ouvrier exécuté par le thread courant
+thread_local const AgentScheduler* currentScheduler = nullptr;
+thread_local std::size_t currentWorker = 0;
+
+} // namespace
+
+void RoutinePromise::FinalAwaiter::await_suspend(std::coroutine_handle<RoutinePromise> handle) noexcept {
+    handle.promise().scheduler->finish(handle);
+}
+
+void AgentScheduler::SleepAwaiter::await_suspend(Routine::Handle handle) {
+    if (delay == 0) {
+        scheduler.wake(handle);
+    } else {
+        scheduler.schedule(handle, SimClock::now() + delay);
+    }
+}
+
+bool AgentScheduler::TradeAwaiter::await_ready() {
+    completed = seller.tryTrade(what, qty, bill);
+    return completed;
+}
+
+void AgentScheduler::TradeAwaiter::await_suspend(Routine::Handle handle) {
+    // Le vendeur est occupé : on laisse passer les autres routines
+    scheduler.wake(handle);
+}
+
+bool AgentScheduler::TradeAwaiter::await_resume() {
+    return completed || seller.tryTrade(what, qty, bill);
+}
+
+bool AgentScheduler::FundsAwaiter::await_ready() const {
+    return seller.getFund() >= amount || scheduler.stopRequested();
+}
+
+bool AgentScheduler::FundsAwaiter::await_suspend(Routine::Handle handle) {
+    // Une fois inscrite, la routine peut être reprise et cet awaiter détruit
+    // par un autre ouvrier : plus rien ne doit y être lu
+    return seller.waitForFunds(handle, amount);
+}
+
+AgentScheduler::AgentScheduler(unsigned nbWorkers) {
+    if (nbWorkers == 0) {
+        nbWorkers = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < nbWorkers; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+}
+
+AgentScheduler::~AgentScheduler() {
+    requestStop();
+    join();
+
+    // Routines jamais démarrées
+    for (Routine::Handle handle : routines) {
+        handle.destroy();
+    }
+}
+
+void AgentScheduler::add(Seller* agent) {
+    spawn(stepRoutine(agent), agent);
+}
+
+void AgentScheduler::addRoutine(Seller* agent) {
+    spawn(agent->routine(*this), agent);
+}
+
+void AgentScheduler::spawn(Routine routine, Seller* agent) {
+    Routine::Handle handle = routine.release();
+    handle.promise().agent     = agent;
+    handle.promise().scheduler = this;
+    agents.push_back(agent);
+    routines.push_back(handle);
+}
+
+Routine AgentScheduler::stepRoutine(Seller* agent) {
+    if (!agent->begin()) {
+        co_return;
+    }
+
+    while (!stopping) {
+        std::uint64_t delay = agent->step();
+        if (int amount = agent->takeAwaitedFunds()) {
+            // Reprise par la vente qui crédite le vendeur plutôt qu'à l'échéance
+            co_await funds(*agent, amount);
+        } else {
+            co_await sleep(delay);
+        }
+    }
+
+    agent->end();
+}
+
+void AgentScheduler::start() {
+    runningRoutines = routines.size();
+
+    std::size_t next = 0;
+    for (Routine::Handle handle : routines) {
+        push(next++ % workers.size(), handle);
+    }
+    routines.clear();
+
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        threads.emplace_back(&AgentScheduler::work, this, i);
+    }
+}
+
+void AgentScheduler::requestStop() {
+    stopping = true;
+    for (Seller* agent : agents) {
+        agent->wakeFundWaiters();
+    }
+    notifyIdle(true);
+}
+
+void AgentScheduler::join() {
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void AgentScheduler::wake(Routine::Handle handle) {
+    if (currentScheduler == this) {
+        push(currentWorker, handle);
+    } else {
+        push(nextQueue++ % workers.size(), handle);
+    }
+}
+
+void AgentScheduler::finish(Routine::Handle handle) {
+    handle.destroy();
+    if (--runningRoutines == 0) {
+        notifyIdle(true);
+    }
+}
+
+void AgentScheduler::work(std::size_t index) {
+    currentScheduler = this;
+    currentWorker    = index;
+
+    for (;;) {
+        Routine::Handle handle = take(index);
+        if (!handle) {
+            handle = popDueAlarm();
+        }
+        if (handle) {
+            execute(handle);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(alarmMutex);
+        if (runningRoutines == 0) {
+            break;
+        }
+        if (readyTasks > 0) {
+            continue;
+        }
+        std::uint64_t now = SimClock::now();
+        if (!alarms.empty() && (stopping || alarms.top().wakeTime <= now)) {
+            continue;
+        }
+
+        ++idleWorkers;
+        if (alarms.empty()) {
+            wakeUp.wait(lock);
+        } else if (SimClock::getMode() == ClockMode::AsFastAsPossible) {
+            if (idleWorkers == workers.size()) {
+                // Plus personne ne travaille : on saute au prochain réveil
+                SimClock::advanceTo(alarms.top().wakeTime);
+            } else {
+                wakeUp.wait(lock);
+            }
+        } else {
+            wakeUp.wait_for(lock, SimClock::toRealTime(alarms.top().wakeTime - now));
+        }
+        --idleWorkers;
+    }
+
+    currentScheduler = nullptr;
+}
+
+void AgentScheduler::execute(Routine::Handle handle) {
+    handle.promise().agent->bindGenerator();
+    handle.resume();
+}
+
+Routine::Handle AgentScheduler::take(std::size_t index) {
+    if (readyTasks == 0) {
+        return {};
+    }
+
+    // Sa propre file d'abord, par la fin (tâche la plus chaude en cache)
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            Routine::Handle handle = own.tasks.back();
+            own.tasks.pop_back();
+            --readyTasks;
+            return handle;
+        }
+    }
+
+    // Puis vol de la tâche la plus ancienne des autres ouvriers
+    for (std::size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            Routine::Handle handle = victim.tasks.front();
+            victim.tasks.pop_front();
+            --readyTasks;
+            return handle;
+        }
+    }
+
+    return {};
+}
+
+Routine::Handle AgentScheduler::popDueAlarm() {
+    std::lock_guard<std::mutex> lock(alarmMutex);
+    if (alarms.empty() || (!stopping && alarms.top().wakeTime > SimClock::now())) {
+        return {};
+    }
+    Routine::Handle handle = alarms.top().handle;
+    alarms.pop();
+    return handle;
+}
+
+void AgentScheduler::push(std::size_t index, Routine::Handle handle) {
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(handle);
+        ++readyTasks;
+    }
+    notifyIdle();
+}
+
+void AgentScheduler::schedule(Routine::Handle handle, std::uint64_t wakeTime) {
+    {
+        std::lock_guard<std::mutex> lock(alarmMutex);
+        alarms.push({wakeTime, nextOrder++, handle});
+    }
+    notifyIdle();
+}
+
+void AgentScheduler::notifyIdle(bool all) {
+    std::lock_guard<std::mutex> lock(alarmMutex);
+    if (all) {
+        wakeUp.notify_all();
+    } else if (idleWorkers > 0) {
+        wakeUp.notify_one();
+    }
+}
@@ -0,0 +1,213 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "routine.h"
+#include "stockledger.h"
+
+class Seller;
+
+/**
+ * @brief Manière d'exécuter les routines des vendeurs
+ *
+ * Threads : un thread par vendeur (comportement historique).
+ * WorkStealing : les étapes des vendeurs (Seller::step()) sont des tâches
+ *                exécutées par AgentScheduler.
+ * Coroutines : les routines coroutines des vendeurs (Seller::routine()) sont
+ *              exécutées par AgentScheduler.
+ */
+enum class ExecutionMode { Threads, WorkStealing, Coroutines };
+
+/**
+ * @brief Ordonnanceur à vol de tâches exécutant les routines des vendeurs.
+ *
+ * Chaque routine est une coroutine (Routine). Un thread ouvrier la reprend
+ * jusqu'à son prochain co_await, qui la remet soit dans la file de l'ouvrier
+ * (reprise immédiate), soit dans la file des réveils ordonnée sur le temps
+ * simulé, soit dans la liste d'attente d'un vendeur (fonds). Un ouvrier sans
+ * travail vole la tâche la plus ancienne de la file d'un autre. Une attente ne
+ * bloque donc jamais de thread et le nombre de vendeurs n'est plus limité par
+ * le nombre de threads.
+ *
+ * En mode ClockMode::AsFastAsPossible, dès que tous les ouvriers sont inactifs
+ * l'horloge saute directement au prochain réveil.
+ */
+class AgentScheduler {
+public:
+    /**
+     * @brief Attente d'un temps simulé, 0 cède simplement la main
+     */
+    struct SleepAwaiter {
+        AgentScheduler& scheduler;
+        std::uint64_t delay;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Routine::Handle handle);
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @brief Tentative d'achat auprès d'un vendeur, sans jamais bloquer
+     *        l'ouvrier. Si le vendeur est occupé, la routine cède la main aux
+     *        autres et retente une fois à sa reprise.
+     * @return false (par co_await) si le vendeur était encore occupé : rien
+     *         n'a été fait, l'achat est à retenter
+     */
+    struct TradeAwaiter {
+        AgentScheduler& scheduler;
+        Seller& seller;
+        ItemType what;
+        int qty;
+        // Facture si la vente a eu lieu (0 si indisponible)
+        int& bill;
+        bool completed = false;
+
+        bool await_ready();
+        void await_suspend(Routine::Handle handle);
+        bool await_resume();
+    };
+
+    /**
+     * @brief Attente que le vendeur dispose d'au moins amount, réveillée par
+     *        la vente qui le crédite (ou par la demande d'arrêt)
+     */
+    struct FundsAwaiter {
+        AgentScheduler& scheduler;
+        Seller& seller;
+        int amount;
+
+        bool await_ready() const;
+        bool await_suspend(Routine::Handle handle);
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @param nbWorkers Nombre de threads ouvriers, 0 pour un par coeur
+     */
+    explicit AgentScheduler(unsigned nbWorkers = 0);
+
+    ~AgentScheduler();
+
+    /**
+     * @brief Ajoute un vendeur exécuté étape par étape (Seller::step()), avant start()
+     */
+    void add(Seller* agent);
+
+    /**
+     * @brief Ajoute un vendeur exécuté par sa routine coroutine, avant start()
+     */
+    void addRoutine(Seller* agent);
+
+    /**
+     * @brief Démarre les ouvriers
+     */
+    void start();
+
+    /**
+     * @brief Demande l'arrêt : les attentes en cours sont écourtées et chaque
+     *        routine se termine à sa prochaine reprise
+     */
+    void requestStop();
+
+    bool stopRequested() const { return stopping; }
+
+    /**
+     * @brief Attend la fin de toutes les routines
+     */
+    void join();
+
+    SleepAwaiter sleep(std::uint64_t us) { return {*this, us}; }
+
+    TradeAwaiter trade(Seller& seller, ItemType what, int qty, int& bill) {
+        return {*this, seller, what, qty, bill};
+    }
+
+    FundsAwaiter funds(Seller& seller, int amount) { return {*this, seller, amount}; }
+
+    /**
+     * @brief Rend une routine suspendue prête à être reprise
+     */
+    void wake(Routine::Handle handle);
+
+private:
+    friend struct RoutinePromise::FinalAwaiter;
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Routine::Handle> tasks;
+    };
+
+    struct Alarm {
+        std::uint64_t wakeTime;
+        std::uint64_t order;
+        Routine::Handle handle;
+
+        bool operator>(const Alarm& other) const {
+            return wakeTime != other.wakeTime ? wakeTime > other.wakeTime
+                                              : order > other.order;
+        }
+    };
+
+    /**
+     * @brief Routine coroutine enchaînant les étapes d'un vendeur
+     */
+    Routine stepRoutine(Seller* agent);
+
+    void spawn(Routine routine, Seller* agent);
+
+    /**
+     * @brief Détruit une routine terminée
+     */
+    void finish(Routine::Handle handle);
+
+    /**
+     * @brief Boucle d'un thread ouvrier
+     */
+    void work(std::size_t index);
+
+    /**
+     * @brief Reprend une routine jusqu'à sa prochaine suspension
+     */
+    void execute(Routine::Handle handle);
+
+    /**
+     * @brief Prend une tâche dans sa propre file, sinon en vole une
+     */
+    Routine::Handle take(std::size_t index);
+
+    /**
+     * @brief Retire un réveil arrivé à échéance
+     */
+    Routine::Handle popDueAlarm();
+
+    void push(std::size_t index, Routine::Handle handle);
+    void schedule(Routine::Handle handle, std::uint64_t wakeTime);
+    void notifyIdle(bool all = false);
+
+    std::vector<Seller*> agents;
+    std::vector<Routine::Handle> routines;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    // Protège alarms, nextOrder et idleWorkers
+    std::mutex alarmMutex;
+    std::condition_variable wakeUp;
+    std::priority_queue<Alarm, std::vector<Alarm>, std::greater<Alarm>> alarms;
+    std::uint64_t nextOrder = 0;
+    std::size_t idleWorkers = 0;
+
+    std::atomic<std::size_t> readyTasks{0};
+    std::atomic<std::size_t> runningRoutines{0};
+    std::atomic<std::size_t> nextQueue{0};
+    std::atomic<bool> stopping{false};
+};
+
+#endif // SCHEDULER_H
@@ -1,35 +1,260 @@
 #include "seller.h"
-#include <algorithm>
-#include <random>
-#include <cassert>
+#include <array>
+#include <iterator>
+#include "checkpoint.h"
+#include "fundauditor.h"
+#include "rng.h"
+#include "scheduler.h"
+#include "simclock.h"
+#include <pcosynchro/pcothread.h>
 
-Seller *Seller::chooseRandomSeller(std::vector<Seller *> &sellers) {
-    assert(sellers.size());
-    std::vector<Seller*> out;
-    std::sample(sellers.begin(), sellers.end(), std::back_inserter(out),
-            1, std::mt19937{std::random_device{}()});
-    return out.front();
+TradeMode Seller::tradeMode = TradeMode::Locked;
+
+void Seller::setTradeMode(TradeMode mode) {
+    tradeMode = mode;
+}
+
+TradeMode Seller::getTradeMode() {
+    return tradeMode;
+}
+
+void Seller::run() {
+    if (!begin()) {
+        return;
+    }
+
+    while (!PcoThread::thisThread()->stopRequested()) {
+        std::uint64_t delay = step();
+        if (int amount = takeAwaitedFunds()) {
+            sleepUntilFunds(amount, delay);
+        } else if (delay) {
+            SimClock::sleep(delay, waker);
+        }
+    }
+
+    end();
+}
+
+bool Seller::begin() {
+    Rng::bind(&generator);
+    return routineStart();
+}
+
+std::uint64_t Seller::step() {
+    Rng::bind(&generator);
+    return routineStep();
+}
+
+void Seller::end() {
+    Rng::bind(&generator);
+    routineEnd();
+}
+
+StockSnapshot Seller::getItemsForSale() const {
+    auto published = itemsForSale.load();
+    return {published.version, published.value};
+}
+
+std::uint64_t Seller::getItemsForSaleVersion() const {
+    return itemsForSale.version();
+}
+
+void Seller::publishStocks() {
+    // Tout en seq_cst : chaque écrivain écrit une variable puis lit l'autre
+    // (publishRequests puis publishing, publishing puis publishRequests).
+    // Avec release/acquire, la relecture pourrait passer avant clear() et
+    // une demande vue « en cours de publication » ne serait jamais publiée.
+    publishRequests.fetch_add(1, std::memory_order_seq_cst);
+    while (!publishing.test_and_set(std::memory_order_seq_cst)) {
+        unsigned seen = publishRequests.load(std::memory_order_seq_cst);
+        itemsForSale.store(listItemsForSale());
+        publishing.clear(std::memory_order_seq_cst);
+
+        // Une demande arrivée pendant la publication n'a pas pu la faire
+        // elle-même, on recommence pour elle.
+        if (publishRequests.load(std::memory_order_seq_cst) == seen) {
+            return;
+        }
+    }
+}
+
+int Seller::sell(ItemType what, int qty, int unitCost) {
+    INSTRUMENT(ScopedLatency latency(metrics.tradeLatency));
+    if (tradeMode == TradeMode::LockFree) {
+        return sellHeld(what, qty, unitCost);
+    }
+
+    InstrumentedMutex& mutex = stockMutex(what);
+    mutex.lock();
+    int bill = sellHeld(what, qty, unitCost);
+    mutex.unlock();
+    return bill;
+}
+
+bool Seller::trySell(ItemType what, int qty, int unitCost, int& bill) {
+    INSTRUMENT(ScopedLatency latency(metrics.tradeLatency));
+    if (tradeMode == TradeMode::LockFree) {
+        bill = sellHeld(what, qty, unitCost);
+        return true;
+    }
+
+    InstrumentedMutex& mutex = stockMutex(what);
+    if (!mutex.trylock()) {
+        INSTRUMENT(metrics.fail(TradeFailure::Busy));
+        return false;
+    }
+    bill = sellHeld(what, qty, unitCost);
+    mutex.unlock();
+    return true;
+}
+
+int Seller::sellHeld(ItemType what, int qty, int unitCost) {
+    int cost = qty * unitCost;
+
+    if (tradeMode == TradeMode::LockFree) {
+        if (!stocks.tryTake(what, qty)) {
+            INSTRUMENT(metrics.fail(TradeFailure::OutOfStock));
+            return 0;
+        }
+    } else {
+        if (stocks.get(what) < qty) {
+            INSTRUMENT(metrics.fail(TradeFailure::OutOfStock));
+            return 0;
+        }
+        stocks.add(what, -qty);
+    }
+
+    money += cost;
+    FundAuditor::credit(cost);
+    publishStocks();
+    wakeFundWaiters();
+    return cost;
+}
+
+void Seller::saveState(SellerState& state) {
+    transactionMutex.lock();
+    state = {};
+    state.id = uniqueId;
+    state.money = money;
+    for (std::size_t i = 0; i < NB_ITEM_TYPES; ++i) {
+        auto item = static_cast<ItemType>(i);
+        if (stocks.contains(item)) {
+            state.listed = static_cast<std::uint8_t>(state.listed | (1U << i));
+        }
+        state.stocks[i] = stocks.get(item);
+    }
+    saveProgress(state);
+    transactionMutex.unlock();
+}
+
+void Seller::restoreState(const SellerState& state) {
+    money = state.money;
+    for (std::size_t i = 0; i < NB_ITEM_TYPES; ++i) {
+        auto item = static_cast<ItemType>(i);
+        if (state.listed & (1U << i)) {
+            stocks.list(item);
+        }
+        if (int delta = state.stocks[i] - stocks.get(item)) {
+            stocks.add(item, delta);
+        }
+    }
+    restoreProgress(state);
+    publishStocks();
+}
+
+bool Seller::waitForFunds(Routine::Handle handle, int amount) {
+    fundMutex.lock();
+    fundWaiters.push_back(handle);
+    ++nbFundWaiters;
+    // Relus après l'inscription : soit on voit le crédit ou l'arrêt, soit le
+    // vendeur ou AgentScheduler::requestStop() nous voit
+    if (money >= amount || handle.promise().scheduler->stopRequested()) {
+        fundWaiters.pop_back();
+        --nbFundWaiters;
+        fundMutex.unlock();
+        return false;
+    }
+    fundMutex.unlock();
+    return true;
 }
 
-ItemType Seller::chooseRandomItem(std::map<ItemType, int> &itemsForSale) {
-    if (!itemsForSale.size()) {
+std::uint64_t Seller::awaitFunds(int amount) {
+    fundsAwaited = amount;
+    return FUND_WAIT_TIMEOUT_US;
+}
+
+void Seller::sleepUntilFunds(int amount, std::uint64_t timeout) {
+    fundMutex.lock();
+    fundThreadWaiting = true;
+    ++nbFundWaiters;
+    // Relu après l'inscription : soit on voit le crédit, soit le vendeur nous voit
+    bool funded = money >= amount;
+    fundMutex.unlock();
+
+    if (!funded) {
+        SimClock::sleep(timeout, waker);
+    }
+
+    fundMutex.lock();
+    if (fundThreadWaiting) {
+        fundThreadWaiting = false;
+        --nbFundWaiters;
+    }
+    // Un crédit arrivé après le réveil ne doit pas écourter le sommeil suivant
+    waker.reset();
+    fundMutex.unlock();
+}
+
+void Seller::wakeFundWaiters() {
+    if (nbFundWaiters == 0) {
+        return;
+    }
+
+    fundMutex.lock();
+    std::vector<Routine::Handle> waiters;
+    waiters.swap(fundWaiters);
+    if (fundThreadWaiting) {
+        fundThreadWaiting = false;
+        waker.wake();
+    }
+    nbFundWaiters = 0;
+    fundMutex.unlock();
+
+    for (Routine::Handle handle : waiters) {
+        handle.promise().scheduler->wake(handle);
+    }
+}
+
+ItemType Seller::chooseRandomItem(const StockLedger &itemsForSale) {
+    if (itemsForSale.empty()) {
         return ItemType::Nothing;
     }
-    std::vector<std::pair<ItemType, int> > out;
-    std::sample(itemsForSale.begin(), itemsForSale.end(), std::back_inserter(out),
-            1, std::mt19937{std::random_device{}()});
-    return out.front().first;
+    auto it = itemsForSale.begin();
+    std::advance(it, static_cast<std::ptrdiff_t>(Rng::below(itemsForSale.size())));
+    return (*it).first;
 }
 
+namespace {
+
+// Prix unitaires indexés par ItemType, costs.h par défaut
+std::array<int, NB_ITEM_TYPES> costPerUnit = {
+    SAND_COST, COPPER_COST, PETROL_COST, CHIP_COST, PLASTIC_COST, ROBOT_COST};
+
+// Salaires indexés par EmployeeType, costs.h par défaut
+std::array<int, NB_EMPLOYEE_TYPES> employeeSalary = {
+    EXTRACOTR_COST, ELECTRICIAN_COST, PLASTIC_COST, ENGINEER_COST};
+
+} // namespace
+
 int getCostPerUnit(ItemType item) {
-    switch (item) {
-        case ItemType::Sand : return SAND_COST;
-        case ItemType::Copper : return COPPER_COST;
-        case ItemType::Petrol : return PETROL_COST;
-        case ItemType::Chip : return CHIP_COST;
-        case ItemType::Plastic : return PLASTIC_COST;
-        case ItemType::Robot : return ROBOT_COST;
-        default : return 0;
+    auto index = static_cast<std::size_t>(item);
+    return index < costPerUnit.size() ? costPerUnit[index] : 0;
+}
+
+void setCostPerUnit(ItemType item, int cost) {
+    auto index = static_cast<std::size_t>(item);
+    if (index < costPerUnit.size()) {
+        costPerUnit[index] = cost;
     }
 }
 
@@ -59,11 +284,13 @@ EmployeeType getEmployeeThatProduces(ItemType item) {
 }
 
 int getEmployeeSalary(EmployeeType employee) {
-    switch (employee) {
-        case EmployeeType::Extractor : return EXTRACOTR_COST;
-        case EmployeeType::Electrician : return ELECTRICIAN_COST;
-        case EmployeeType::Engineer : return ENGINEER_COST;
-        case EmployeeType::Plasturgist : return PLASTIC_COST;
-        default : return 0;
+    auto index = static_cast<std::size_t>(employee);
+    return index < employeeSalary.size() ? employeeSalary[index] : 0;
+}
+
+void setEmployeeSalary(EmployeeType employee, int salary) {
+    auto index = static_cast<std::size_t>(employee);
+    if (index < employeeSalary.size()) {
+        employeeSalary[index] = salary;
     }
 }
@@ -3,34 +3,128 @@
 
 #include <QString>
 #include <QStringBuilder>
-#include <map>
+#include <atomic>
+#include <span>
+#include <utility>
 #include <vector>
 #include "costs.h"
+#include "instrumentation.h"
+#include "rng.h"
+#include "routine.h"
+#include "seqlock.h"
+#include "simclock.h"
+#include "stockledger.h"
 #include <pcosynchro/pcomutex.h> // PcoMutex
 
-enum class ItemType { Sand, Copper, Petrol, Chip, Plastic, Robot, Nothing};
+class AgentScheduler;
+struct SellerState;
+
+// Attente maximale, en temps simulé (us), d'un vendeur sans fonds en mode
+// Threads : filet de sécurité si aucune vente ne vient le réveiller
+#define FUND_WAIT_TIMEOUT_US 100000
 
 int getCostPerUnit(ItemType item);
 QString getItemName(ItemType item);
 
 enum class EmployeeType {Extractor, Electrician, Plasturgist, Engineer};
 
+constexpr std::size_t NB_EMPLOYEE_TYPES = 4;
+
 EmployeeType getEmployeeThatProduces(ItemType item);
 int getEmployeeSalary(EmployeeType employee);
 
+/**
+ * @brief Remplacent les prix et salaires par défaut de costs.h.
+ *        Doivent être appelées avant le lancement des threads.
+ */
+void setCostPerUnit(ItemType item, int cost);
+void setEmployeeSalary(EmployeeType employee, int salary);
+
+/**
+ * @brief Manière dont trade() protège le stock et l'argent du vendeur
+ *
+ * Locked : trade() prend transactionMutex (comportement historique).
+ * LockFree : trade() retire le stock par compare-and-swap et crédite l'argent
+ *            par une addition atomique, sans jamais prendre de verrou.
+ */
+enum class TradeMode { Locked, LockFree };
+
+/**
+ * @brief Instantané immuable du stock mis en vente par un vendeur
+ */
+struct StockSnapshot {
+    // Numéro de publication, croissant à chaque modification du stock
+    std::uint64_t version;
+    StockLedger items;
+};
+
 class Seller {
 public:
     /**
      * @brief Seller
      * @param money money money !
      */
-    Seller(int money, int uniqueId) : money(money), uniqueId(uniqueId) {}
+    Seller(int money, int uniqueId)
+        : money(money), uniqueId(uniqueId), generator(Rng::forStream(static_cast<std::uint64_t>(uniqueId))) {}
+
+    virtual ~Seller() { INSTRUMENT(Instrumentation::remove(metrics)); }
+
+    /**
+     * @brief Routine du vendeur sur son propre thread (fonction threadée) :
+     *        enchaîne les étapes jusqu'à la demande d'arrêt du thread
+     */
+    void run();
+
+    /**
+     * @brief Écourte l'attente en cours de run(), ou la suivante. À appeler
+     *        après la demande d'arrêt du thread pour qu'il la voie aussitôt.
+     */
+    void interrupt() { waker.wake(); }
+
+    /**
+     * @brief Démarre la routine
+     * @return false si le vendeur ne peut pas fonctionner
+     */
+    bool begin();
+
+    /**
+     * @brief Exécute une étape de la routine. Ne bloque jamais longtemps : les
+     *        attentes sont rendues à l'appelant, ce qui permet d'exécuter les
+     *        vendeurs comme des tâches (voir AgentScheduler).
+     * @return Le temps simulé (en microsecondes) à attendre avant l'étape
+     *         suivante, 0 pour l'enchaîner directement
+     */
+    std::uint64_t step();
+
+    /**
+     * @brief Termine la routine
+     */
+    void end();
 
     /**
-     * @brief getItemsForSale
+     * @brief Routine du vendeur écrite comme une coroutine, exécutée par
+     *        scheduler en mode ExecutionMode::Coroutines. Les attentes de
+     *        temps, de fonds et de fin d'achat sont des co_await.
+     */
+    virtual Routine routine(AgentScheduler& scheduler) = 0;
+
+    /**
+     * @brief Fait utiliser le générateur du vendeur par le thread appelant
+     */
+    void bindGenerator() { Rng::bind(&generator); }
+
+    /**
+     * @brief Dernier instantané publié des objets à vendre. La lecture ne prend
+     *        aucun verrou, n'alloue rien et ne peut pas être déchirée.
      * @return The list of items for sale
      */
-    virtual std::map<ItemType, int> getItemsForSale() = 0;
+    StockSnapshot getItemsForSale() const;
+
+    /**
+     * @brief Version du dernier instantané publié, permet de savoir à moindre
+     *        coût si le stock a changé depuis une lecture précédente
+     */
+    std::uint64_t getItemsForSaleVersion() const;
 
     /**
      * @brief Fonction permettant d'acheter des ressources au vendeur
@@ -41,35 +135,177 @@ public:
     virtual int trade(ItemType what, int qty) = 0;
 
     /**
-     * @brief chooseRandomSeller
-     * @param sellers
-     * @return Returns a random seller from the sellers vector
+     * @brief Variante non bloquante de trade()
+     * @param bill La facture si la vente a eu lieu (0 si indisponible)
+     * @return false si le vendeur est occupé par une autre vente, rien n'a
+     *         alors été fait
      */
-    static Seller* chooseRandomSeller(std::vector<Seller*>& sellers);
+    virtual bool tryTrade(ItemType what, int qty, int& bill) = 0;
 
     /**
-     * @brief Chooses a random item type from an items for sale map
+     * @brief Inscrit une routine en attente d'au moins amount de fonds
+     * @return false si les fonds sont déjà disponibles ou si l'arrêt de son
+     *         ordonnanceur est demandé (rien n'est inscrit)
+     */
+    bool waitForFunds(Routine::Handle handle, int amount);
+
+    /**
+     * @brief Rend prêtes toutes les routines en attente de fonds, elles
+     *        vérifient elles-mêmes si le montant attendu est atteint. Réveille
+     *        aussi le thread du vendeur s'il attend des fonds (voir run()).
+     */
+    void wakeFundWaiters();
+
+    /**
+     * @brief Montant attendu par la dernière étape (voir awaitFunds()),
+     *        remis à zéro par la lecture
+     * @return 0 si l'étape n'attend pas de fonds
+     */
+    int takeAwaitedFunds() { return std::exchange(fundsAwaited, 0); }
+
+    /**
+     * @brief Chooses a random item type from an items for sale ledger
      * @param itemsForSale
      * @return Returns the item type
      */
-    static ItemType chooseRandomItem(std::map<ItemType, int>& itemsForSale);
+    static ItemType chooseRandomItem(const StockLedger& itemsForSale);
+
+    /**
+     * @brief Choisit le mode de vente utilisé par tous les vendeurs.
+     *        Doit être appelé avant le lancement des threads.
+     */
+    static void setTradeMode(TradeMode mode);
+
+    static TradeMode getTradeMode();
+
+    /**
+     * @brief Copie l'état du vendeur dans un point de reprise (voir
+     *        Checkpoint). Prend transactionMutex : aucune production ni
+     *        salaire ne peut être copié à moitié.
+     */
+    void saveState(SellerState& state);
+
+    /**
+     * @brief Reprend l'état d'un point de reprise. Doit être appelé avant le
+     *        lancement des threads.
+     */
+    void restoreState(const SellerState& state);
 
     int getFund() { return money; }
 
     int getUniqueId() { return uniqueId; }
 
 protected:
+    /**
+     * @brief Implémentation de begin(), step() et end() propre à chaque vendeur
+     */
+    virtual bool routineStart() = 0;
+    virtual std::uint64_t routineStep() = 0;
+    virtual void routineEnd() = 0;
+
+    /**
+     * @brief Construit la vue des objets à vendre à partir du stock courant
+     */
+    virtual StockLedger listItemsForSale() = 0;
+
+    /**
+     * @brief Partie de l'état propre à chaque vendeur (type, production en
+     *        cours, employés payés), appelée par saveState() et restoreState()
+     */
+    virtual void saveProgress(SellerState& state) = 0;
+    virtual void restoreProgress(const SellerState& state) = 0;
+
+    /**
+     * @brief Verrou qui protège le stock d'un objet pendant une vente en mode
+     *        Locked : transactionMutex, sauf pour un vendeur qui partitionne
+     *        son stock par objet
+     */
+    virtual InstrumentedMutex& stockMutex(ItemType) { return transactionMutex; }
+
+    /**
+     * @brief Annonce que l'étape en cours ne peut continuer sans au moins
+     *        amount de fonds. run() attend alors la vente qui crédite le
+     *        vendeur plutôt que l'échéance, un ordonnanceur fait de même.
+     * @return Le délai à rendre par l'étape, plafond de l'attente
+     */
+    std::uint64_t awaitFunds(int amount);
+
+    /**
+     * @brief Publie un nouvel instantané des objets à vendre. Doit être appelé
+     *        après chaque modification du stock. Peut être appelé de plusieurs
+     *        threads à la fois : si une publication est déjà en cours, c'est
+     *        elle qui reprendra la modification et l'appel retourne aussitôt.
+     */
+    void publishStocks();
+
+    /**
+     * @brief Vend qty unités d'un objet du stock au prix unitaire donné.
+     *
+     * Factorise le coeur des trade() : en mode Locked la vente se fait sous
+     * stockMutex(what), en mode LockFree le stock est décrémenté par CAS puis
+     * l'argent crédité atomiquement. La somme d'argent est conservée dans les
+     * deux cas : le vendeur n'est crédité que si le stock a été retiré.
+     * @return La facture, 0 si le stock est insuffisant
+     */
+    int sell(ItemType what, int qty, int unitCost);
+
+    /**
+     * @brief Comme sell(), mais renonce si stockMutex(what) est déjà pris
+     * @return false si la vente n'a pas pu être tentée
+     */
+    bool trySell(ItemType what, int qty, int unitCost, int& bill);
+
     /**
      * @brief stocks : Type, Quantité
      */
-    std::map<ItemType, int> stocks;
-    int money;
+    AtomicStockLedger stocks;
+    std::atomic<int> money;
     int uniqueId;
 
     /**
      * @brief Mutex used to avoid concurrency while manipulating money or stock.
      */
-    PcoMutex transactionMutex;
+    InstrumentedMutex transactionMutex;
+
+#ifdef PCO_INSTRUMENTATION
+    SellerMetrics metrics;
+#endif
+
+private:
+    static TradeMode tradeMode;
+
+    // Générateur aléatoire propre au vendeur, quel que soit le thread qui l'exécute
+    Xoshiro256 generator;
+
+    // Instantané publié des objets à vendre
+    SeqLock<StockLedger> itemsForSale;
+    // Nombre de demandes de publication, sert à détecter celles manquées
+    std::atomic<unsigned> publishRequests{0};
+    // Vrai pendant qu'un thread publie (sérialise les écrivains du seqlock)
+    std::atomic_flag publishing = ATOMIC_FLAG_INIT;
+
+    // Routines en attente de fonds, protégées par fundMutex
+    PcoMutex fundMutex;
+    std::vector<Routine::Handle> fundWaiters;
+    // Thread du vendeur en attente de fonds (mode Threads), protégé par fundMutex
+    bool fundThreadWaiting = false;
+    // Nombre d'attentes inscrites, lu sans verrou pour ne rien payer sans attente
+    std::atomic<std::size_t> nbFundWaiters{0};
+    // Réveille le thread du vendeur endormi dans run() (fonds ou arrêt)
+    SimClock::Waker waker;
+    // Montant attendu par la dernière étape, 0 sinon (voir awaitFunds())
+    int fundsAwaited = 0;
+
+    /**
+     * @brief Attente de fonds du thread du vendeur, écourtée par la vente qui
+     *        le crédite
+     */
+    void sleepUntilFunds(int amount, std::uint64_t timeout);
+
+    /**
+     * @brief Vend qty unités, stockMutex(what) étant déjà pris en mode Locked
+     */
+    int sellHeld(ItemType what, int qty, int unitCost);
 };
 
 #endif // SELLER_H
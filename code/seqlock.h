@@ -0,0 +1,87 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Cellule protégée par un verrou séquentiel (seqlock).
+ *
+ * Les lecteurs ne prennent jamais de verrou et n'allouent rien : ils copient
+ * la valeur puis vérifient que le numéro de séquence n'a pas bougé entre-temps,
+ * sinon ils recommencent. Une lecture ne peut donc jamais observer une valeur
+ * à moitié écrite. La valeur est stockée mot par mot dans des atomiques pour
+ * que les lectures concurrentes restent définies au sens du modèle mémoire.
+ *
+ * Les écrivains doivent être sérialisés par l'appelant.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SeqLock ne peut contenir que des types trivialement copiables");
+
+public:
+    /**
+     * @brief Valeur lue accompagnée de son numéro de version
+     */
+    struct Versioned {
+        std::uint64_t version;
+        T value;
+    };
+
+    /**
+     * @brief Publie une nouvelle valeur (un seul écrivain à la fois)
+     */
+    void store(const T& value) {
+        std::array<std::uint64_t, NB_WORDS> raw{};
+        std::memcpy(raw.data(), &value, sizeof(T));
+
+        std::uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < NB_WORDS; ++i) {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Lit une copie cohérente de la dernière valeur publiée
+     */
+    Versioned load() const {
+        std::array<std::uint64_t, NB_WORDS> raw;
+        for (;;) {
+            std::uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;  // Publication en cours
+            }
+            for (std::size_t i = 0; i < NB_WORDS; ++i) {
+                raw[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                Versioned result{before / 2, T{}};
+                std::memcpy(static_cast<void*>(&result.value), raw.data(), sizeof(T));
+                return result;
+            }
+        }
+    }
+
+    /**
+     * @brief Numéro de version de la dernière valeur publiée
+     */
+    std::uint64_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr std::size_t NB_WORDS = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> sequence{0};
+    std::array<std::atomic<std::uint64_t>, NB_WORDS> words{};
+};
+
+#endif // SEQLOCK_H
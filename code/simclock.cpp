@@ -0,0 +1,150 @@
+/**
+ * @file simclock.cpp
+ * @brief Implementation of the simulation clock
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "simclock.h"
+#include "rng.h"
+
+ClockMode SimClock::mode = ClockMode::RealTime;
+double SimClock::speed = 1.0;
+std::chrono::steady_clock::time_point SimClock::start = std::chrono::steady_clock::now();
+
+std::mutex SimClock::mutex;
+std::priority_queue<SimClock::Alarm, std::vector<SimClock::Alarm>, std::greater<SimClock::Alarm>> SimClock::timeline;
+std::atomic<std::uint64_t> SimClock::virtualNow{0};
+std::uint64_t SimClock::nextOrder = 0;
+unsigned SimClock::participants = 0;
+unsigned SimClock::sleeping = 0;
+
+std::uint64_t DelayRange::draw() const {
+    if (max <= min) {
+        return min;
+    }
+    std::uint64_t unit = step ? step : 1;
+    return min + Rng::below((max - min) / unit + 1) * unit;
+}
+
+void SimClock::configure(ClockMode clockMode, double clockSpeed) {
+    mode  = clockMode;
+    speed = clockMode == ClockMode::Scaled && clockSpeed > 0.0 ? clockSpeed : 1.0;
+    start = std::chrono::steady_clock::now();
+    virtualNow.store(0);
+}
+
+ClockMode SimClock::getMode() {
+    return mode;
+}
+
+std::uint64_t SimClock::now() {
+    if (mode == ClockMode::AsFastAsPossible) {
+        return virtualNow.load(std::memory_order_acquire);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start).count();
+    return static_cast<std::uint64_t>(static_cast<double>(elapsed) * speed);
+}
+
+void SimClock::sleep(std::uint64_t us, Waker& waker) {
+    std::unique_lock<std::mutex> guard = lock(waker);
+    if (waker.pending) {
+        waker.pending = false;
+        return;
+    }
+
+    if (mode != ClockMode::AsFastAsPossible) {
+        waker.wakeUp.wait_for(guard, toRealTime(us), [&waker] { return waker.pending; });
+        waker.pending = false;
+        return;
+    }
+
+    auto sleeper = std::make_shared<Sleeper>();
+    timeline.push({virtualNow.load(std::memory_order_relaxed) + us, nextOrder++, sleeper});
+    ++sleeping;
+    waker.sleeper = sleeper;
+    advance();
+    sleeper->wakeUp.wait(guard, [&sleeper] { return sleeper->ready; });
+    waker.sleeper.reset();
+}
+
+void SimClock::Waker::wake() {
+    std::unique_lock<std::mutex> guard = SimClock::lock(*this);
+    if (sleeper && !sleeper->ready) {
+        // Son réveil reste dans la file, advance() l'ignorera
+        sleeper->ready = true;
+        --sleeping;
+        sleeper->wakeUp.notify_one();
+        sleeper.reset();
+    } else {
+        pending = true;
+        wakeUp.notify_one();
+    }
+}
+
+void SimClock::Waker::reset() {
+    std::unique_lock<std::mutex> guard = SimClock::lock(*this);
+    pending = false;
+}
+
+std::unique_lock<std::mutex> SimClock::lock(Waker& waker) {
+    return std::unique_lock<std::mutex>(mode == ClockMode::AsFastAsPossible ? mutex : waker.mutex);
+}
+
+std::chrono::microseconds SimClock::toRealTime(std::uint64_t us) {
+    if (mode == ClockMode::AsFastAsPossible) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::microseconds(static_cast<std::int64_t>(static_cast<double>(us) / speed));
+}
+
+void SimClock::advanceTo(std::uint64_t time) {
+    if (mode != ClockMode::AsFastAsPossible) {
+        return;
+    }
+    std::uint64_t current = virtualNow.load(std::memory_order_relaxed);
+    while (current < time &&
+           !virtualNow.compare_exchange_weak(current, time, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+    }
+}
+
+void SimClock::attach(unsigned nb) {
+    std::lock_guard<std::mutex> lock(mutex);
+    participants += nb;
+}
+
+void SimClock::detach() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (participants > 0) {
+        --participants;
+    }
+    advance();
+}
+
+void SimClock::advance() {
+    // Réveils d'agents déjà réveillés par un Waker
+    while (!timeline.empty() && timeline.top().sleeper->ready) {
+        timeline.pop();
+    }
+    if (sleeping < participants || timeline.empty()) {
+        return;
+    }
+
+    // Tout le monde dort : on saute au prochain réveil et on réveille tous
+    // les agents prévus à cet instant.
+    std::uint64_t wakeTime = timeline.top().wakeTime;
+    virtualNow.store(wakeTime, std::memory_order_release);
+    while (!timeline.empty() && timeline.top().wakeTime == wakeTime) {
+        std::shared_ptr<Sleeper> sleeper = timeline.top().sleeper;
+        timeline.pop();
+        if (sleeper->ready) {
+            continue;
+        }
+        sleeper->ready = true;
+        --sleeping;
+        sleeper->wakeUp.notify_one();
+    }
+}
@@ -0,0 +1,166 @@
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+/**
+ * @brief Manière dont le temps simulé avance
+ *
+ * RealTime : une microseconde simulée dure une microseconde réelle.
+ * Scaled : le temps simulé avance speed fois plus vite que le temps réel.
+ * AsFastAsPossible : simulation à événements discrets, dès que tous les agents
+ *                    dorment, l'horloge saute directement au prochain réveil.
+ */
+enum class ClockMode { RealTime, Scaled, AsFastAsPossible };
+
+/**
+ * @brief Durée simulée aléatoire, uniforme dans [min, max] par pas de step
+ *        microsecondes
+ */
+struct DelayRange {
+    std::uint64_t min;
+    std::uint64_t max;
+    std::uint64_t step = 1;
+
+    /**
+     * @brief Tire une durée avec le générateur du thread appelant (voir Rng)
+     */
+    std::uint64_t draw() const;
+};
+
+/**
+ * @brief Horloge de la simulation, utilisée par toutes les routines à la place
+ *        de PcoThread::usleep().
+ *
+ * En mode AsFastAsPossible, l'horloge doit connaître le nombre d'agents actifs
+ * (attach()/detach()) pour savoir quand tous sont endormis et qu'elle peut
+ * avancer. Un agent bloqué ailleurs que dans sleep() (ex: sur un mutex) est
+ * considéré comme actif et retient donc l'horloge.
+ */
+class SimClock {
+    struct Sleeper;
+
+public:
+    /**
+     * @brief Permet à un autre thread d'écourter un sommeil (voir
+     *        sleep(us, waker)). Un réveil demandé hors sommeil écourte le
+     *        suivant, aucun n'est donc perdu.
+     */
+    class Waker {
+    public:
+        /**
+         * @brief Réveille l'agent endormi sur ce Waker
+         */
+        void wake();
+
+        /**
+         * @brief Oublie un réveil demandé hors sommeil
+         */
+        void reset();
+
+    private:
+        friend class SimClock;
+
+        // Protège pending hors du mode AsFastAsPossible, où SimClock::mutex
+        // protège pending et sleeper
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        bool pending = false;
+        // Sommeil en cours en mode AsFastAsPossible
+        std::shared_ptr<Sleeper> sleeper;
+    };
+
+    /**
+     * @brief Choisit le mode de l'horloge et remet le temps simulé à zéro.
+     *        Doit être appelé avant le lancement des threads.
+     * @param speed Facteur d'accélération, utilisé en mode Scaled seulement
+     */
+    static void configure(ClockMode mode, double speed = 1.0);
+
+    static ClockMode getMode();
+
+    /**
+     * @brief Temps simulé écoulé depuis configure(), en microsecondes
+     */
+    static std::uint64_t now();
+
+    /**
+     * @brief Endort l'appelant pendant us microsecondes de temps simulé, ou
+     *        jusqu'à ce que waker.wake() soit appelé. Un agent réveillé avant
+     *        l'heure ne fait pas avancer l'horloge.
+     */
+    static void sleep(std::uint64_t us, Waker& waker);
+
+    /**
+     * @brief Durée réelle correspondant à us microsecondes de temps simulé
+     *        (nulle en mode AsFastAsPossible)
+     */
+    static std::chrono::microseconds toRealTime(std::uint64_t us);
+
+    /**
+     * @brief Fait avancer le temps virtuel jusqu'à time. Réservé aux
+     *        ordonnanceurs qui gèrent eux-mêmes leurs réveils en mode
+     *        AsFastAsPossible, sans effet dans les autres modes.
+     */
+    static void advanceTo(std::uint64_t time);
+
+    /**
+     * @brief Déclare nb agents supplémentaires participant à la simulation
+     */
+    static void attach(unsigned nb = 1);
+
+    /**
+     * @brief Retire un agent de la simulation (fin de sa routine)
+     */
+    static void detach();
+
+private:
+    struct Sleeper {
+        std::condition_variable wakeUp;
+        bool ready = false;
+    };
+
+    struct Alarm {
+        std::uint64_t wakeTime;
+        std::uint64_t order;
+        // Partagé avec le dormeur : un réveil écourté reste dans la file et
+        // sera ignoré
+        std::shared_ptr<Sleeper> sleeper;
+
+        bool operator>(const Alarm& other) const {
+            return wakeTime != other.wakeTime ? wakeTime > other.wakeTime
+                                              : order > other.order;
+        }
+    };
+
+    /**
+     * @brief Avance le temps virtuel si tous les participants dorment.
+     *        Doit être appelé avec mutex verrouillé.
+     */
+    static void advance();
+
+    /**
+     * @brief Prend le verrou qui protège l'état de waker dans le mode courant
+     */
+    static std::unique_lock<std::mutex> lock(Waker& waker);
+
+    static ClockMode mode;
+    static double speed;
+    static std::chrono::steady_clock::time_point start;
+
+    static std::mutex mutex;
+    static std::priority_queue<Alarm, std::vector<Alarm>, std::greater<Alarm>> timeline;
+    static std::atomic<std::uint64_t> virtualNow;
+    static std::uint64_t nextOrder;
+    static unsigned participants;
+    static unsigned sleeping;
+};
+
+#endif // SIMCLOCK_H
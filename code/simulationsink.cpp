@@ -0,0 +1,42 @@
+/**
+ * @file simulationsink.cpp
+ * @brief Implementation of the display-less simulation sinks
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "simulationsink.h"
+#include "eventlog.h"
+#include "seller.h"
+
+FileSink::FileSink(const std::string& path) : out(path) {}
+
+void FileSink::writeEvents() {
+    std::lock_guard<std::mutex> lock(mutex);
+    EventLog::dump(out);
+}
+
+void FileSink::updateFund(unsigned int id, unsigned new_fund) {
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "fund " << id << ' ' << new_fund << '\n';
+}
+
+void FileSink::updateStock(unsigned int id, const StockLedger& stocks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "stock " << id;
+    for (auto [item, qty] : stocks) {
+        out << ' ' << getItemName(item).toStdString() << '=' << qty;
+    }
+    out << '\n';
+}
+
+void FileSink::writeFlows(const TradeFlows& flows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t i = 0; i < flows.size(); ++i) {
+        if (std::uint64_t units = flows.units(i)) {
+            out << "flow " << flows.link(i).buyer << ' ' << flows.link(i).seller << ' ' << units
+                << '\n';
+        }
+    }
+}
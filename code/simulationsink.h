@@ -0,0 +1,67 @@
+#ifndef SIMULATIONSINK_H
+#define SIMULATIONSINK_H
+
+#include <QString>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include "stockledger.h"
+#include "tradeflows.h"
+
+/**
+ * @brief Destination des notifications émises par les vendeurs.
+ *
+ * Les vendeurs ne connaissent que cette interface : l'interface graphique
+ * (WindowInterface) en est une implémentation parmi d'autres, ce qui permet de
+ * faire tourner la simulation sans affichage. Les messages des consoles ne
+ * passent pas par ici mais par le journal d'événements (voir EventLog).
+ */
+class SimulationSink {
+public:
+    virtual ~SimulationSink() = default;
+
+    /**
+     * @brief Dernier état connu d'une entité. Le stock est une copie : aucun
+     *        pointeur vers l'état vivant d'un vendeur ne quitte son thread.
+     */
+    virtual void updateFund(unsigned int id, unsigned new_fund) = 0;
+    virtual void updateStock(unsigned int id, const StockLedger& stocks) = 0;
+};
+
+/**
+ * @brief Ignore toutes les notifications (mode sans affichage le plus rapide)
+ */
+class NullSink : public SimulationSink {
+public:
+    void updateFund(unsigned int, unsigned) override {}
+    void updateStock(unsigned int, const StockLedger&) override {}
+};
+
+/**
+ * @brief Écrit toutes les notifications, une par ligne, dans un fichier texte
+ */
+class FileSink : public SimulationSink {
+public:
+    explicit FileSink(const std::string& path);
+
+    void updateFund(unsigned int id, unsigned new_fund) override;
+    void updateStock(unsigned int id, const StockLedger& stocks) override;
+
+    /**
+     * @brief Écrit les événements conservés par le journal (voir EventLog)
+     */
+    void writeEvents();
+
+    /**
+     * @brief Écrit les unités échangées sur chaque lien qui en a vu passer
+     */
+    void writeFlows(const TradeFlows& flows);
+
+    bool isOpen() const { return out.is_open(); }
+
+private:
+    std::ofstream out;
+    std::mutex mutex;
+};
+
+#endif // SIMULATIONSINK_H
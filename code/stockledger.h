@@ -0,0 +1,195 @@
+#ifndef STOCKLEDGER_H
+#define STOCKLEDGER_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+enum class ItemType { Sand, Copper, Petrol, Chip, Plastic, Robot, Nothing};
+
+/**
+ * @brief Nombre de types d'objets réels (ItemType::Nothing exclu)
+ */
+constexpr std::size_t NB_ITEM_TYPES = static_cast<std::size_t>(ItemType::Nothing);
+
+/**
+ * @brief Registre de stock dense, indexé directement par ItemType.
+ *
+ * Remplace l'ancienne std::map<ItemType, int> : chaque accès est une simple
+ * lecture dans un tableau de taille fixe et aucun noeud n'est jamais alloué.
+ * Un objet est "listé" dès qu'il a été touché, ce qui reproduit le
+ * comportement d'insertion de std::map::operator[] : l'itération parcourt
+ * exactement les mêmes entrées qu'avant, dans l'ordre de l'enum.
+ */
+class alignas(64) StockLedger {
+public:
+    /**
+     * @brief Itérateur sur les objets listés, produisant des paires (type, quantité)
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::pair<ItemType, int>;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = value_type;
+
+        const_iterator() = default;
+        const_iterator(const StockLedger* ledger, std::size_t index)
+            : ledger(ledger), index(index) { skipUnlisted(); }
+
+        value_type operator*() const {
+            return {static_cast<ItemType>(index), ledger->quantities[index]};
+        }
+
+        const_iterator& operator++() {
+            ++index;
+            skipUnlisted();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+
+    private:
+        void skipUnlisted() {
+            while (index < NB_ITEM_TYPES && !(ledger->listed & (1U << index))) {
+                ++index;
+            }
+        }
+
+        const StockLedger* ledger = nullptr;
+        std::size_t index = NB_ITEM_TYPES;
+    };
+
+    /**
+     * @brief Quantité en stock d'un objet, 0 s'il n'est pas listé
+     */
+    int get(ItemType item) const { return quantities[slot(item)]; }
+
+    /**
+     * @brief Fixe la quantité d'un objet et le liste
+     */
+    void set(ItemType item, int qty) {
+        list(item);
+        quantities[slot(item)] = qty;
+    }
+
+    /**
+     * @brief Ajoute (ou retire si qty < 0) des unités d'un objet et le liste
+     */
+    void add(ItemType item, int qty = 1) {
+        list(item);
+        quantities[slot(item)] += qty;
+    }
+
+    /**
+     * @brief Liste un objet sans modifier sa quantité
+     */
+    void list(ItemType item) { listed |= static_cast<std::uint8_t>(1U << slot(item)); }
+
+    bool contains(ItemType item) const {
+        return item != ItemType::Nothing && (listed & (1U << slot(item)));
+    }
+
+    std::size_t size() const { return static_cast<std::size_t>(std::popcount(listed)); }
+
+    bool empty() const { return listed == 0; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, NB_ITEM_TYPES); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+    static std::size_t slot(ItemType item) { return static_cast<std::size_t>(item); }
+
+    std::array<int, NB_ITEM_TYPES> quantities{};
+    std::uint8_t listed = 0;
+};
+
+/**
+ * @brief Variante partagée du registre, dont chaque case est atomique.
+ *
+ * C'est le stock vivant d'un vendeur : il peut être lu sans verrou et
+ * tryTake() permet de retirer des unités par compare-and-swap, ce qui sert
+ * de base au mode de vente sans verrou (TradeMode::LockFree). load() en
+ * extrait une copie StockLedger pour l'itération.
+ */
+class alignas(64) AtomicStockLedger {
+public:
+    int get(ItemType item) const {
+        return quantities[slot(item)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Ajoute (ou retire si qty < 0) des unités d'un objet et le liste
+     */
+    void add(ItemType item, int qty = 1) {
+        list(item);
+        quantities[slot(item)].fetch_add(qty, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Retire qty unités si le stock le permet, de manière atomique
+     * @return true si les unités ont été retirées, false si le stock est insuffisant
+     */
+    bool tryTake(ItemType item, int qty) {
+        std::atomic<int>& quantity = quantities[slot(item)];
+        int current = quantity.load(std::memory_order_relaxed);
+        do {
+            if (current < qty) {
+                return false;
+            }
+        } while (!quantity.compare_exchange_weak(current, current - qty,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * @brief Liste un objet sans modifier sa quantité
+     */
+    void list(ItemType item) {
+        if (!contains(item)) {
+            listed.fetch_or(static_cast<std::uint8_t>(1U << slot(item)),
+                            std::memory_order_relaxed);
+        }
+    }
+
+    bool contains(ItemType item) const {
+        return item != ItemType::Nothing &&
+               (listed.load(std::memory_order_relaxed) & (1U << slot(item)));
+    }
+
+    /**
+     * @brief Copie des objets listés et de leurs quantités
+     */
+    StockLedger load() const {
+        StockLedger copy;
+        for (std::size_t i = 0; i < NB_ITEM_TYPES; ++i) {
+            ItemType item = static_cast<ItemType>(i);
+            if (contains(item)) {
+                copy.set(item, get(item));
+            }
+        }
+        return copy;
+    }
+
+private:
+    static std::size_t slot(ItemType item) { return static_cast<std::size_t>(item); }
+
+    std::array<std::atomic<int>, NB_ITEM_TYPES> quantities{};
+    std::atomic<std::uint8_t> listed{0};
+};
+
+#endif // STOCKLEDGER_H
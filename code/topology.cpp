@@ -0,0 +1,246 @@
+/**
+ * @file topology.cpp
+ * @brief Implementation of the supply network generator
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "topology.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include "rng.h"
+
+namespace {
+
+// Flux de Rng::forStream() réservé au tirage de la topologie
+constexpr std::uint64_t TOPOLOGY_STREAM = 0x746F706FULL;
+
+/**
+ * Indices i de [0, n[ tels que i * regions / n == region
+ */
+std::pair<std::uint64_t, std::uint64_t> regionRange(std::uint64_t region, std::uint64_t n,
+                                                    std::uint64_t regions) {
+    return {(region * n + regions - 1) / regions, ((region + 1) * n + regions - 1) / regions};
+}
+
+std::vector<std::uint32_t> shuffled(unsigned n) {
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0U);
+    for (std::size_t i = n; i > 1; --i) {
+        std::swap(order[i - 1], order[Rng::below(i)]);
+    }
+    return order;
+}
+
+/**
+ * Générateurs d'un graphe biparti lignes -> cibles, une ligne par acheteur.
+ * Les lignes sont produites dans l'ordre, ce qui remplit le CSR en une passe.
+ */
+struct TopologyBuilder {
+    template<typename Csr>
+    static void full(Csr& csr, unsigned rows, unsigned nbTargets) {
+        csr.targets.reserve(std::size_t(rows) * nbTargets);
+        for (unsigned r = 0; r < rows; ++r) {
+            for (unsigned t = 0; t < nbTargets; ++t) {
+                csr.targets.push_back(t);
+            }
+            csr.endRow();
+        }
+    }
+
+    /**
+     * Ligne de degree cibles distinctes uniformes parmi pool : Fisher-Yates
+     * partiel, pool reste une permutation et sert à la ligne suivante
+     */
+    template<typename Csr>
+    static void sampleRow(Csr& csr, std::vector<std::uint32_t>& pool, unsigned degree) {
+        std::size_t count = std::min<std::size_t>(degree, pool.size());
+        for (std::size_t j = 0; j < count; ++j) {
+            std::swap(pool[j], pool[j + Rng::below(pool.size() - j)]);
+            csr.targets.push_back(pool[j]);
+        }
+        csr.endRow();
+    }
+
+    template<typename Csr>
+    static void fanOut(Csr& csr, unsigned rows, unsigned nbTargets, unsigned degree) {
+        std::vector<std::uint32_t> pool(nbTargets);
+        std::iota(pool.begin(), pool.end(), 0U);
+        csr.targets.reserve(std::size_t(rows) * degree);
+        for (unsigned r = 0; r < rows; ++r) {
+            sampleRow(csr, pool, degree);
+        }
+    }
+
+    /**
+     * Fenêtre glissante sur une permutation : degree cibles distinctes par
+     * ligne et des degrés entrants qui diffèrent d'au plus un
+     */
+    template<typename Csr>
+    static void regular(Csr& csr, unsigned rows, unsigned nbTargets, unsigned degree) {
+        std::vector<std::uint32_t> order = shuffled(nbTargets);
+        csr.targets.reserve(std::size_t(rows) * degree);
+        std::size_t position = 0;
+        for (unsigned r = 0; r < rows; ++r) {
+            for (unsigned j = 0; j < degree; ++j) {
+                csr.targets.push_back(order[(position + j) % nbTargets]);
+            }
+            position = (position + degree) % nbTargets;
+            csr.endRow();
+        }
+    }
+
+    /**
+     * Attachement préférentiel : une cible est choisie avec une probabilité
+     * proportionnelle à 1 + son degré, en tirant soit une cible uniforme soit
+     * une extrémité d'arête déjà posée
+     */
+    template<typename Csr>
+    static void scaleFree(Csr& csr, unsigned rows, unsigned nbTargets, unsigned degree) {
+        constexpr unsigned MAX_TRIES = 16;
+        std::vector<std::uint32_t> lastRow(nbTargets, UINT32_MAX);
+        csr.targets.reserve(std::size_t(rows) * degree);
+        for (unsigned r = 0; r < rows; ++r) {
+            for (unsigned j = 0; j < degree; ++j) {
+                std::uint32_t target = 0;
+                bool found = false;
+                for (unsigned tries = 0; tries < MAX_TRIES && !found; ++tries) {
+                    std::uint64_t u = Rng::below(nbTargets + csr.targets.size());
+                    target = u < nbTargets ? std::uint32_t(u) : csr.targets[u - nbTargets];
+                    found = lastRow[target] != r;
+                }
+                // Pivot déjà pris trop souvent : première cible libre suivante
+                while (!found) {
+                    target = (target + 1) % nbTargets;
+                    found = lastRow[target] != r;
+                }
+                lastRow[target] = r;
+                csr.targets.push_back(target);
+            }
+            csr.endRow();
+        }
+    }
+};
+
+} // namespace
+
+Topology Topology::generate(const TopologyOptions& options, unsigned nbExtractors,
+                            unsigned nbFactories, unsigned nbWholesalers) {
+    Topology topology;
+    const unsigned nbSuppliers = nbExtractors + nbFactories;
+    if (nbWholesalers == 0 || nbSuppliers == 0) {
+        return topology;
+    }
+
+    Xoshiro256 generator = options.seed ? Xoshiro256(options.seed) : Rng::forStream(TOPOLOGY_STREAM);
+    // Le thread appelant retrouve ensuite le générateur qu'il avait lié
+    Xoshiro256* previous = Rng::bind(&generator);
+
+    Csr& supply = topology.supply;
+    Csr& demand = topology.demand;
+    switch (options.kind) {
+        case TopologyKind::Sliced: {
+            unsigned extractorsByWholesaler = nbExtractors / nbWholesalers;
+            unsigned extractorsShared = nbExtractors % nbWholesalers;
+            unsigned factoriesByWholesaler = nbFactories / nbWholesalers;
+            unsigned factoriesShared = nbFactories % nbWholesalers;
+
+            for (unsigned w = 0; w < nbWholesalers; ++w) {
+                for (unsigned e = w * extractorsByWholesaler; e < (w + 1) * extractorsByWholesaler; ++e) {
+                    supply.targets.push_back(e);
+                }
+                for (unsigned e = nbExtractors - extractorsShared; e < nbExtractors; ++e) {
+                    supply.targets.push_back(e);
+                }
+                for (unsigned f = w * factoriesByWholesaler; f < (w + 1) * factoriesByWholesaler; ++f) {
+                    supply.targets.push_back(nbExtractors + f);
+                }
+                for (unsigned f = nbFactories - factoriesShared; f < nbFactories; ++f) {
+                    supply.targets.push_back(nbExtractors + f);
+                }
+                supply.endRow();
+            }
+            TopologyBuilder::full(demand, nbFactories, nbWholesalers);
+            break;
+        }
+
+        case TopologyKind::Full:
+            TopologyBuilder::full(supply, nbWholesalers, nbSuppliers);
+            TopologyBuilder::full(demand, nbFactories, nbWholesalers);
+            break;
+
+        case TopologyKind::Regional: {
+            // Chaque région a au moins un grossiste et un fournisseur
+            unsigned regions = std::clamp(options.regions, 1U,
+                                          std::min(nbWholesalers, std::max(nbExtractors, nbFactories)));
+            // Les acheteurs sont parcourus région par région : chaque réserve
+            // de partenaires n'est remplie qu'une fois
+            std::vector<std::uint32_t> pool;
+            std::uint64_t poolRegion = UINT64_MAX;
+            for (unsigned w = 0; w < nbWholesalers; ++w) {
+                std::uint64_t region = std::uint64_t(w) * regions / nbWholesalers;
+                if (region != poolRegion) {
+                    auto [firstExtractor, lastExtractor] = regionRange(region, nbExtractors, regions);
+                    auto [firstFactory, lastFactory] = regionRange(region, nbFactories, regions);
+                    pool.clear();
+                    for (std::uint64_t e = firstExtractor; e < lastExtractor; ++e) {
+                        pool.push_back(std::uint32_t(e));
+                    }
+                    for (std::uint64_t f = firstFactory; f < lastFactory; ++f) {
+                        pool.push_back(std::uint32_t(nbExtractors + f));
+                    }
+                    poolRegion = region;
+                }
+                TopologyBuilder::sampleRow(supply, pool, options.degree);
+            }
+            poolRegion = UINT64_MAX;
+            for (unsigned f = 0; f < nbFactories; ++f) {
+                std::uint64_t region = std::uint64_t(f) * regions / nbFactories;
+                if (region != poolRegion) {
+                    auto [first, last] = regionRange(region, nbWholesalers, regions);
+                    pool.clear();
+                    for (std::uint64_t w = first; w < last; ++w) {
+                        pool.push_back(std::uint32_t(w));
+                    }
+                    poolRegion = region;
+                }
+                TopologyBuilder::sampleRow(demand, pool, options.degree);
+            }
+            break;
+        }
+
+        case TopologyKind::BoundedFanOut:
+            TopologyBuilder::fanOut(supply, nbWholesalers, nbSuppliers, std::clamp(options.degree, 1U, nbSuppliers));
+            TopologyBuilder::fanOut(demand, nbFactories, nbWholesalers, std::clamp(options.degree, 1U, nbWholesalers));
+            break;
+
+        case TopologyKind::ScaleFree:
+            TopologyBuilder::scaleFree(supply, nbWholesalers, nbSuppliers, std::clamp(options.degree, 1U, nbSuppliers));
+            TopologyBuilder::scaleFree(demand, nbFactories, nbWholesalers, std::clamp(options.degree, 1U, nbWholesalers));
+            break;
+
+        case TopologyKind::RandomRegular:
+            TopologyBuilder::regular(supply, nbWholesalers, nbSuppliers, std::clamp(options.degree, 1U, nbSuppliers));
+            TopologyBuilder::regular(demand, nbFactories, nbWholesalers, std::clamp(options.degree, 1U, nbWholesalers));
+            break;
+    }
+
+    Rng::bind(previous);
+    return topology;
+}
+
+Topology Topology::fromAdjacency(const std::vector<std::vector<std::uint32_t>>& suppliers,
+                                 const std::vector<std::vector<std::uint32_t>>& wholesalers) {
+    Topology topology;
+    for (const auto& row : suppliers) {
+        topology.supply.targets.insert(topology.supply.targets.end(), row.begin(), row.end());
+        topology.supply.endRow();
+    }
+    for (const auto& row : wholesalers) {
+        topology.demand.targets.insert(topology.demand.targets.end(), row.begin(), row.end());
+        topology.demand.endRow();
+    }
+    return topology;
+}
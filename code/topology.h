@@ -0,0 +1,94 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Forme du réseau d'approvisionnement
+ *
+ * Sliced : découpage historique, chaque grossiste reçoit une tranche des mines
+ *          et des usines plus le reste partagé, chaque usine tous les grossistes.
+ * Full : graphe biparti complet.
+ * Regional : les entités sont réparties en régions, chaque acheteur choisit
+ *            au plus degree partenaires au hasard dans sa région.
+ * BoundedFanOut : chaque acheteur choisit degree partenaires au hasard.
+ * ScaleFree : comme BoundedFanOut mais par attachement préférentiel, quelques
+ *             vendeurs deviennent des pivots très sollicités.
+ * RandomRegular : chaque acheteur a degree partenaires et chaque vendeur en a
+ *                 autant que possible le même nombre.
+ */
+enum class TopologyKind { Sliced, Full, Regional, BoundedFanOut, ScaleFree, RandomRegular };
+
+struct TopologyOptions {
+    TopologyKind kind = TopologyKind::Sliced;
+    // Nombre de régions (Regional)
+    unsigned regions = 4;
+    // Nombre de partenaires par acheteur (toutes les formes sauf Sliced et Full)
+    unsigned degree = 4;
+    // Graine du tirage, 0 pour la dériver de la graine maître (voir Rng)
+    std::uint64_t seed = 0;
+};
+
+/**
+ * @brief Réseau d'approvisionnement entre mines, usines et grossistes.
+ *
+ * Les listes d'adjacence sont stockées au format CSR (un tableau de décalages
+ * et un tableau plat de voisins) : deux allocations au total quelle que soit
+ * la taille du graphe. Les fournisseurs sont numérotés de 0 à nbExtractors - 1
+ * pour les mines puis à la suite pour les usines. Toutes les formes se
+ * construisent en temps linéaire en nombre d'arêtes.
+ */
+class Topology {
+public:
+    static Topology generate(const TopologyOptions& options, unsigned nbExtractors,
+                             unsigned nbFactories, unsigned nbWholesalers);
+
+    /**
+     * @brief Topologie donnée par ses listes d'adjacence, par exemple relues
+     *        d'un point de reprise
+     * @param suppliers Fournisseurs de chaque grossiste
+     * @param wholesalers Grossistes de chaque usine
+     */
+    static Topology fromAdjacency(const std::vector<std::vector<std::uint32_t>>& suppliers,
+                                  const std::vector<std::vector<std::uint32_t>>& wholesalers);
+
+    /**
+     * @brief Fournisseurs (mines et usines) chez qui un grossiste achète
+     */
+    std::span<const std::uint32_t> suppliersOf(unsigned wholesaler) const {
+        return supply.row(wholesaler);
+    }
+
+    /**
+     * @brief Grossistes chez qui une usine achète
+     */
+    std::span<const std::uint32_t> wholesalersOf(unsigned factory) const {
+        return demand.row(factory);
+    }
+
+    std::size_t nbSupplyLinks() const { return supply.targets.size(); }
+
+    std::size_t nbDemandLinks() const { return demand.targets.size(); }
+
+private:
+    struct Csr {
+        std::vector<std::size_t> offsets{0};
+        std::vector<std::uint32_t> targets;
+
+        std::span<const std::uint32_t> row(std::size_t i) const {
+            return {targets.data() + offsets[i], offsets[i + 1] - offsets[i]};
+        }
+
+        void endRow() { offsets.push_back(targets.size()); }
+    };
+
+    // Grossiste -> fournisseurs
+    Csr supply;
+    // Usine -> grossistes
+    Csr demand;
+};
+
+#endif // TOPOLOGY_H
@@ -0,0 +1,303 @@
+/**
+ * @file tradebench.cpp
+ * @brief Throughput and latency micro-benchmark of the sellers' trade()
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "instrumentation.h"
+#include "simulationsink.h"
+#include "utils.h"
+
+/**
+ * Usage : PCO_Labo_3_tradebench [--threads=n] [--duration=ms] [--sellers=n]
+ *                               [--clé=valeur ...]
+ *
+ * Mesure trade() des mines, des usines et des grossistes, de 1 à n threads
+ * (puissances de deux, n compris), sous trois formes de charge :
+ *   hot       tous les threads achètent au même vendeur
+ *   uniform   chaque achat vise un vendeur tiré au hasard
+ *   prodcons  la moitié des threads réapprovisionnent les vendeurs pendant que
+ *             l'autre moitié achète, sur un stock initialement vide (à partir
+ *             de 2 threads)
+ *
+ * Les autres options sont celles de scenario.h (trade.mode, seed, prix...).
+ * La progression est écrite sur la sortie d'erreur et les résultats, en JSON,
+ * sur la sortie standard.
+ */
+
+namespace {
+
+// Stock de départ, assez grand pour ne jamais être épuisé pendant une mesure
+constexpr int AMPLE_STOCK = 1 << 30;
+
+enum class Pattern { Hot, Uniform, ProducerConsumer };
+
+const char* getPatternName(Pattern pattern) {
+    switch (pattern) {
+        case Pattern::Hot : return "hot";
+        case Pattern::Uniform : return "uniform";
+        case Pattern::ProducerConsumer : return "prodcons";
+        default : return "???";
+    }
+}
+
+/**
+ * @brief Vendeurs dont le stock peut être rempli directement, comme le ferait
+ *        leur routine après une extraction, une fabrication ou un achat
+ */
+class BenchExtractor : public SandExtractor {
+public:
+    using SandExtractor::SandExtractor;
+
+    ItemType getItemSold() { return ItemType::Sand; }
+
+    void restock(int qty) {
+        transactionMutex.lock();
+        stocks.add(ItemType::Sand, qty);
+        publishStocks();
+        transactionMutex.unlock();
+    }
+};
+
+class BenchFactory : public RobotFactory {
+public:
+    using RobotFactory::RobotFactory;
+
+    ItemType getItemSold() { return ItemType::Robot; }
+
+    void restock(int qty) {
+        transactionMutex.lock();
+        stocks.add(ItemType::Robot, qty);
+        publishStocks();
+        transactionMutex.unlock();
+    }
+};
+
+class BenchWholesale : public Wholesale {
+public:
+    using Wholesale::Wholesale;
+
+    ItemType getItemSold() { return ItemType::Sand; }
+
+    void restock(int qty) {
+        transactionMutex.lock();
+        stocks.add(ItemType::Sand, qty);
+        publishStocks();
+        transactionMutex.unlock();
+    }
+};
+
+struct Options {
+    unsigned maxThreads = std::max(1U, std::thread::hardware_concurrency());
+    unsigned durationMs = 1000;
+    unsigned nbSellers = 8;
+};
+
+struct Result {
+    const char* kind;
+    Pattern pattern;
+    unsigned nbThreads;
+    std::uint64_t trades;
+    std::uint64_t failed;
+    double seconds;
+    LatencyHistogram latency;
+};
+
+/**
+ * @brief Compteurs d'un thread, sur leur propre ligne de cache
+ */
+struct alignas(64) WorkerStats {
+    std::uint64_t trades = 0;
+    std::uint64_t failed = 0;
+    LatencyHistogram latency;
+};
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Une mesure : nbThreads threads appellent trade() pendant la durée
+ *        demandée, sur des vendeurs neufs pour partir d'un état identique
+ */
+template <typename BenchSeller>
+void measure(const char* kind, Pattern pattern, unsigned nbThreads, const Options& options,
+             int& nextId, Result& result) {
+    std::vector<std::unique_ptr<BenchSeller>> sellers;
+    for (unsigned i = 0; i < options.nbSellers; ++i) {
+        sellers.push_back(std::make_unique<BenchSeller>(nextId++, 0));
+        if (pattern != Pattern::ProducerConsumer) {
+            sellers.back()->restock(AMPLE_STOCK);
+        }
+    }
+
+    std::vector<WorkerStats> stats(nbThreads);
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+
+    auto work = [&](unsigned index) {
+        Xoshiro256 generator = Rng::forStream(index);
+        Rng::bind(&generator);
+        WorkerStats& mine = stats[index];
+        bool producer = pattern == Pattern::ProducerConsumer && index % 2 == 1;
+
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            BenchSeller& seller = pattern == Pattern::Hot
+                                      ? *sellers[0]
+                                      : *sellers[Rng::below(sellers.size())];
+            if (producer) {
+                seller.restock(1);
+                continue;
+            }
+
+            std::uint64_t start = nowNs();
+            int bill = seller.trade(seller.getItemSold(), 1);
+            mine.latency.record(nowNs() - start);
+            ++mine.trades;
+            if (bill == 0) {
+                ++mine.failed;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < nbThreads; ++i) {
+        threads.emplace_back(work, i);
+    }
+    while (ready.load() < nbThreads) {
+        std::this_thread::yield();
+    }
+
+    std::uint64_t start = nowNs();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.durationMs));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    result.kind = kind;
+    result.pattern = pattern;
+    result.nbThreads = nbThreads;
+    result.seconds = double(nowNs() - start) / 1e9;
+    result.trades = 0;
+    result.failed = 0;
+    for (const WorkerStats& worker : stats) {
+        result.trades += worker.trades;
+        result.failed += worker.failed;
+        result.latency.merge(worker.latency);
+    }
+}
+
+bool parseOption(const std::string& argument, const char* name, unsigned& value) {
+    std::string prefix = std::string("--") + name + "=";
+    if (argument.rfind(prefix, 0) != 0) {
+        return false;
+    }
+    value = static_cast<unsigned>(std::strtoul(argument.c_str() + prefix.size(), nullptr, 10));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Les options du banc sont retirées, le reste est passé au scénario
+    Options options;
+    std::vector<char*> scenarioArguments = {argv[0]};
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (!parseOption(argument, "threads", options.maxThreads) &&
+            !parseOption(argument, "duration", options.durationMs) &&
+            !parseOption(argument, "sellers", options.nbSellers)) {
+            scenarioArguments.push_back(argv[i]);
+        }
+    }
+    options.maxThreads = std::max(1U, options.maxThreads);
+    options.nbSellers = std::max(1U, options.nbSellers);
+
+    Scenario scenario;
+    std::vector<std::string> positional;
+    std::string error;
+    if (!scenario.parseArguments(int(scenarioArguments.size()), scenarioArguments.data(),
+                                 positional, error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    NullSink sink;
+    Extractor::setInterface(&sink);
+    Factory::setInterface(&sink);
+    Wholesale::setInterface(&sink);
+    configureSimulation(scenario);
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned n = 1; n < options.maxThreads; n *= 2) {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(options.maxThreads);
+
+    std::vector<std::unique_ptr<Result>> results;
+    int nextId = 0;
+    for (Pattern pattern : {Pattern::Hot, Pattern::Uniform, Pattern::ProducerConsumer}) {
+        for (unsigned nbThreads : threadCounts) {
+            // Il faut au moins un producteur et un acheteur
+            if (pattern == Pattern::ProducerConsumer && nbThreads < 2) {
+                continue;
+            }
+            for (const char* kind : {"extractor", "factory", "wholesaler"}) {
+                auto result = std::make_unique<Result>();
+                std::string name = kind;
+                if (name == "extractor") {
+                    measure<BenchExtractor>(kind, pattern, nbThreads, options, nextId, *result);
+                } else if (name == "factory") {
+                    measure<BenchFactory>(kind, pattern, nbThreads, options, nextId, *result);
+                } else {
+                    measure<BenchWholesale>(kind, pattern, nbThreads, options, nextId, *result);
+                }
+
+                std::cerr << getPatternName(pattern) << ' ' << kind << " x" << nbThreads << " : "
+                          << std::uint64_t(double(result->trades) / result->seconds)
+                          << " trades/s, p50 " << result->latency.percentile(0.5) << " ns, p99 "
+                          << result->latency.percentile(0.99) << " ns" << std::endl;
+                results.push_back(std::move(result));
+            }
+        }
+    }
+
+    std::cout << "{\"trade_mode\":\""
+              << (scenario.tradeMode == TradeMode::LockFree ? "lockfree" : "locked")
+              << "\",\"duration_ms\":" << options.durationMs
+              << ",\"sellers\":" << options.nbSellers << ",\"results\":[";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& result = *results[i];
+        std::cout << (i ? "," : "") << "\n{\"kind\":\"" << result.kind << "\",\"pattern\":\""
+                  << getPatternName(result.pattern) << "\",\"threads\":" << result.nbThreads
+                  << ",\"trades\":" << result.trades << ",\"failed\":" << result.failed
+                  << ",\"ops_per_s\":" << std::uint64_t(double(result.trades) / result.seconds)
+                  << ",\"p50_ns\":" << result.latency.percentile(0.5)
+                  << ",\"p99_ns\":" << result.latency.percentile(0.99)
+                  << ",\"max_ns\":" << result.latency.max() << '}';
+    }
+    std::cout << "\n]}" << std::endl;
+
+    return EXIT_SUCCESS;
+}
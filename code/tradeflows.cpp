@@ -0,0 +1,19 @@
+/**
+ * @file tradeflows.cpp
+ * @brief Implementation of the per-link trade counters
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "tradeflows.h"
+
+void TradeFlows::assign(std::vector<Link> newLinks) {
+    links = std::move(newLinks);
+    counters = std::make_unique<Counter[]>(links.size());
+    for (std::size_t i = 0; i < links.size(); ++i) {
+        counters[i].owner = this;
+    }
+    changed = std::make_unique<std::atomic<std::uint64_t>[]>(nbWords());
+    changedWords = std::make_unique<std::atomic<std::uint64_t>[]>(nbGroups());
+}
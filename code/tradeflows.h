@@ -0,0 +1,119 @@
+#ifndef TRADEFLOWS_H
+#define TRADEFLOWS_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Compteurs des unités échangées sur chaque lien du réseau.
+ *
+ * Un compteur par lien acheteur -> vendeur, dans l'ordre des adjacences
+ * distribuées par Utils : chaque acheteur reçoit la tranche de compteurs
+ * parallèle à sa tranche de vendeurs et l'incrémente après chaque achat. Le
+ * thread graphique lit les compteurs pour en déduire le débit de chaque lien.
+ *
+ * Chaque achat marque aussi son lien dans un masque à deux niveaux (un bit par
+ * lien, un bit par mot de 64 liens) : forEachChanged() ne visite que les liens
+ * modifiés, son coût suit l'activité et non la taille du réseau.
+ */
+class TradeFlows {
+public:
+    /**
+     * @brief Lien entre deux entités, désignées par leur identifiant
+     */
+    struct Link {
+        std::uint32_t buyer;
+        std::uint32_t seller;
+    };
+
+    struct Counter {
+        std::atomic<std::uint64_t> units{0};
+        // Compteurs dont il fait partie, pour marquer le lien modifié
+        TradeFlows* owner = nullptr;
+    };
+
+    TradeFlows() = default;
+
+    // Les compteurs pointent vers leur TradeFlows
+    TradeFlows(const TradeFlows&) = delete;
+    TradeFlows& operator=(const TradeFlows&) = delete;
+
+    /**
+     * @brief Remplace les liens, tous les compteurs repartent de zéro
+     */
+    void assign(std::vector<Link> links);
+
+    std::size_t size() const { return links.size(); }
+
+    const Link& link(std::size_t index) const { return links[index]; }
+
+    /**
+     * @brief Unités échangées sur le lien depuis le début de la simulation
+     */
+    std::uint64_t units(std::size_t index) const {
+        return counters[index].units.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Tranche de compteurs donnée à un acheteur
+     */
+    std::span<Counter> slice(std::size_t first, std::size_t count) {
+        return {counters.get() + first, count};
+    }
+
+    /**
+     * @brief Ajoute qty unités au compteur d'un lien
+     */
+    static void record(Counter& counter, int qty) {
+        counter.units.fetch_add(static_cast<std::uint64_t>(qty), std::memory_order_relaxed);
+        counter.owner->markChanged(static_cast<std::size_t>(&counter - counter.owner->counters.get()));
+    }
+
+    /**
+     * @brief Appelle visit(index) pour chaque lien dont le compteur a changé
+     *        depuis l'appel précédent. Un seul lecteur à la fois.
+     */
+    template<typename Visitor>
+    void forEachChanged(Visitor&& visit) {
+        for (std::size_t group = 0; group < nbGroups(); ++group) {
+            std::uint64_t words = changedWords[group].exchange(0, std::memory_order_acquire);
+            while (words) {
+                std::size_t word = group * 64 + static_cast<std::size_t>(std::countr_zero(words));
+                words &= words - 1;
+                // Acquire : les unités ajoutées avant le marquage sont visibles
+                std::uint64_t bits = changed[word].exchange(0, std::memory_order_acquire);
+                while (bits) {
+                    visit(word * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+private:
+    std::size_t nbWords() const { return (links.size() + 63) / 64; }
+    std::size_t nbGroups() const { return (nbWords() + 63) / 64; }
+
+    void markChanged(std::size_t index) {
+        // Seul l'achat qui rend un mot non vide marque le mot : un mot non
+        // vide a toujours son bit de groupe, posé avant ou après la lecture
+        std::uint64_t bit = 1ULL << (index % 64);
+        if (changed[index / 64].fetch_or(bit, std::memory_order_release) == 0) {
+            changedWords[index / 4096].fetch_or(1ULL << (index / 64 % 64), std::memory_order_release);
+        }
+    }
+
+    std::vector<Link> links;
+    std::unique_ptr<Counter[]> counters;
+    // Un bit par lien modifié depuis la dernière lecture
+    std::unique_ptr<std::atomic<std::uint64_t>[]> changed;
+    // Un bit par mot non vide de changed
+    std::unique_ptr<std::atomic<std::uint64_t>[]> changedWords;
+};
+
+#endif // TRADEFLOWS_H
@@ -0,0 +1,32 @@
+/**
+ * @file updatechannel.cpp
+ * @brief Implementation of the coalescing display update channel
+ * @author Aubry Mangold <aubry.mangold@heig-vd.ch>
+ * @author Timothée Van Hove <timothee.vanhove@heig-vd.ch>
+ * @date 2026-10-15
+ */
+
+#include "updatechannel.h"
+
+UpdateChannel::UpdateChannel(std::size_t nbEntities)
+    : nbEntities(nbEntities),
+      nbWords((nbEntities + 63) / 64),
+      slots(std::make_unique<Slot[]>(nbEntities)),
+      fundDirty(std::make_unique<std::atomic<std::uint64_t>[]>(nbWords)),
+      stockDirty(std::make_unique<std::atomic<std::uint64_t>[]>(nbWords)) {}
+
+void UpdateChannel::publishFund(unsigned id, unsigned fund) {
+    if (id >= nbEntities) {
+        return;
+    }
+    slots[id].fund.store(fund, std::memory_order_relaxed);
+    markDirty(fundDirty.get(), id);
+}
+
+void UpdateChannel::publishStock(unsigned id, const StockLedger& stock) {
+    if (id >= nbEntities) {
+        return;
+    }
+    slots[id].stock.store(stock);
+    markDirty(stockDirty.get(), id);
+}
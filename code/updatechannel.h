@@ -0,0 +1,98 @@
+#ifndef UPDATECHANNEL_H
+#define UPDATECHANNEL_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "seqlock.h"
+#include "stockledger.h"
+
+/**
+ * @brief Canal de mise à jour de l'affichage qui fusionne les notifications.
+ *
+ * Chaque entité possède un emplacement où ses notifications écrasent la
+ * précédente valeur, puis le marquent modifié dans un masque de bits. Le
+ * lecteur (le thread graphique, à cadence fixe) ne récupère que les
+ * emplacements modifiés depuis son dernier passage : le coût d'affichage ne
+ * dépend plus du nombre de notifications mais du nombre d'entités modifiées
+ * par image, et aucun pointeur vers l'état vivant d'un vendeur ne traverse
+ * les threads.
+ *
+ * Chaque entité ne doit être notifiée que par un thread à la fois (sa routine).
+ */
+class UpdateChannel {
+public:
+    /**
+     * @brief Dernières valeurs d'une entité modifiée
+     */
+    struct Update {
+        unsigned id;
+        bool fundChanged;
+        unsigned fund;
+        bool stockChanged;
+        StockLedger stock;
+    };
+
+    explicit UpdateChannel(std::size_t nbEntities);
+
+    std::size_t size() const { return nbEntities; }
+
+    void publishFund(unsigned id, unsigned fund);
+
+    void publishStock(unsigned id, const StockLedger& stock);
+
+    /**
+     * @brief Appelle apply(const Update&) pour chaque entité modifiée depuis
+     *        l'appel précédent (un seul lecteur)
+     * @return Le nombre d'entités modifiées
+     */
+    template<typename F>
+    std::size_t drain(F&& apply) {
+        std::size_t changed = 0;
+        for (std::size_t word = 0; word < nbWords; ++word) {
+            std::uint64_t funds  = fundDirty[word].exchange(0, std::memory_order_acquire);
+            std::uint64_t stocks = stockDirty[word].exchange(0, std::memory_order_acquire);
+            std::uint64_t dirty  = funds | stocks;
+            while (dirty) {
+                unsigned bit = static_cast<unsigned>(std::countr_zero(dirty));
+                dirty &= dirty - 1;
+
+                Update update{};
+                update.id           = static_cast<unsigned>(word * 64 + bit);
+                update.fundChanged  = funds & (std::uint64_t(1) << bit);
+                update.stockChanged = stocks & (std::uint64_t(1) << bit);
+                const Slot& slot    = slots[update.id];
+                if (update.fundChanged) {
+                    update.fund = slot.fund.load(std::memory_order_relaxed);
+                }
+                if (update.stockChanged) {
+                    update.stock = slot.stock.load().value;
+                }
+                apply(update);
+                ++changed;
+            }
+        }
+        return changed;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<unsigned> fund{0};
+        SeqLock<StockLedger> stock;
+    };
+
+    static void markDirty(std::atomic<std::uint64_t>* words, unsigned id) {
+        words[id / 64].fetch_or(std::uint64_t(1) << (id % 64), std::memory_order_release);
+    }
+
+    std::size_t nbEntities;
+    std::size_t nbWords;
+    std::unique_ptr<Slot[]> slots;
+    // Un bit par entité, remis à zéro par drain()
+    std::unique_ptr<std::atomic<std::uint64_t>[]> fundDirty;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> stockDirty;
+};
+
+#endif // UPDATECHANNEL_H
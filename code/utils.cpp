@@ -7,12 +7,46 @@
  */
 
 #include "utils.h"
+#include "checkpoint.h"
+#include "journal.h"
+#include "rng.h"
+
+void configureSimulation(const Scenario& scenario) {
+    Seller::setTradeMode(scenario.tradeMode);
+    Rng::setMasterSeed(scenario.seed);
+    SimClock::configure(scenario.clockMode, scenario.clockSpeed);
+    EventLog::configure(scenario.logCapacity, scenario.logRetention);
+    Journal::open(scenario.journalFile);
+
+    for (std::size_t i = 0; i < NB_ITEM_TYPES; ++i) {
+        setCostPerUnit(static_cast<ItemType>(i), scenario.prices[i]);
+    }
+    for (std::size_t i = 0; i < NB_EMPLOYEE_TYPES; ++i) {
+        setEmployeeSalary(static_cast<EmployeeType>(i), scenario.salaries[i]);
+    }
 
+    Extractor::setMiningTime(scenario.miningTime);
+    Extractor::setMiners(scenario.extractorMiners);
+    Factory::setAssemblyTime(scenario.assemblyTime);
+    Factory::setWorkers(scenario.factoryWorkers);
+    Factory::setCapacity(scenario.factoryCapacity);
+    Factory::setOrderPause(scenario.orderPause);
+    Wholesale::setPurchasePause(scenario.purchasePause);
+}
 
 void Utils::endService() {
-    // Ask the threads to stop
+    // Ask the threads to stop, then cut their current wait short so that
+    // none of them finishes a sleep of several seconds first
     for (auto& thread : threads)
         thread->requestStop();
+    for (Seller* seller : extractors)
+        seller->interrupt();
+    for (Seller* seller : factories)
+        seller->interrupt();
+    for (Seller* seller : wholesalers)
+        seller->interrupt();
+    if (scheduler)
+        scheduler->requestStop();
 
     std::cout << "It's time to end !" << std::endl;
 }
@@ -23,26 +57,27 @@ void Utils::externalEndService() {
     utilsThread->join();
 }
 
-std::vector<Extractor*> createExtractors(int nbExtractors, int idStart) {
-    if (nbExtractors < 1){
+std::vector<Extractor*> createExtractors(const std::vector<ItemType>& resources, int fund, int idStart) {
+    if (resources.size() < 1){
         qInfo() << "Cannot make the programm work with less than 1 extractor";
         exit(-1);
     }
 
     std::vector<Extractor*> extractors;
 
-    for(int i = 0; i < nbExtractors; ++i) {
-        switch(i % 3) {
-            case 0:
-                extractors.push_back(new SandExtractor(i + idStart, EXTRACTOR_FUND));
+    for(std::size_t i = 0; i < resources.size(); ++i) {
+        int id = static_cast<int>(i) + idStart;
+        switch(resources[i]) {
+            case ItemType::Sand:
+                extractors.push_back(new SandExtractor(id, fund));
                 break;
 
-            case 1:
-                extractors.push_back(new CopperExtractor(i + idStart, EXTRACTOR_FUND));
+            case ItemType::Copper:
+                extractors.push_back(new CopperExtractor(id, fund));
                 break;
 
-            case 2:
-                extractors.push_back(new PetrolExtractor(i + idStart, EXTRACTOR_FUND));
+            default:
+                extractors.push_back(new PetrolExtractor(id, fund));
                 break;
         }
     }
@@ -51,26 +86,27 @@ std::vector<Extractor*> createExtractors(int nbExtractors, int idStart) {
     return extractors;
 }
 
-std::vector<Factory*> createFactories(int nbFactories, int idStart) {
-    if (nbFactories < 1){
+std::vector<Factory*> createFactories(const std::vector<ItemType>& items, int fund, int idStart) {
+    if (items.size() < 1){
         qInfo() << "Cannot make the programm work with less than 1 Factory";
         exit(-1);
     }
 
     std::vector<Factory*> factories;
 
-    for(int i = 0; i < nbFactories; ++i) {
-        switch(i % 3) {
-            case 0:
-                factories.push_back(new PlasticFactory(i + idStart, FACTORIES_FUND));
+    for(std::size_t i = 0; i < items.size(); ++i) {
+        int id = static_cast<int>(i) + idStart;
+        switch(items[i]) {
+            case ItemType::Plastic:
+                factories.push_back(new PlasticFactory(id, fund));
                 break;
 
-            case 1:
-                factories.push_back(new ChipFactory(i + idStart, FACTORIES_FUND));
+            case ItemType::Chip:
+                factories.push_back(new ChipFactory(id, fund));
                 break;
 
-            case 2:
-                factories.push_back(new RobotFactory(i + idStart, FACTORIES_FUND));
+            default:
+                factories.push_back(new RobotFactory(id, fund));
                 break;
         }
     }
@@ -79,7 +115,7 @@ std::vector<Factory*> createFactories(int nbFactories, int idStart) {
     return factories;
 }
 
-std::vector<Wholesale*> createWholesaler(int nbWholesaler, int idStart) {
+std::vector<Wholesale*> createWholesaler(int nbWholesaler, int fund, int idStart) {
     if(nbWholesaler < 1){
         qInfo() << "Cannot launch the programm without any wholesaler";
         exit(-1);
@@ -88,92 +124,293 @@ std::vector<Wholesale*> createWholesaler(int nbWholesaler, int idStart) {
     std::vector<Wholesale*> wholesalers;
 
     for(int i = 0; i < nbWholesaler; ++i){
-        wholesalers.push_back(new Wholesale(i + idStart, WHOLESALERS_FUND));
+        wholesalers.push_back(new Wholesale(i + idStart, fund));
     }
 
     return wholesalers;
 }
 
 
-Utils::Utils(int nbExtractor, int nbFactory, int nbWholesale) {
-    this->extractors.resize(nbExtractor);
-    this->wholesalers.resize(nbWholesale);
-    this->factories.resize(nbFactory);
+Utils::Utils(const Scenario& scenario) : scenario(scenario) {
+    int nbExtractor = int(scenario.nbExtractors);
+    int nbWholesale = int(scenario.nbWholesalers);
 
-    this->extractors = createExtractors(nbExtractor, 0);
-    this->wholesalers = createWholesaler(nbWholesale, nbExtractor);
-    this->factories = createFactories(nbFactory, nbExtractor + nbWholesale);
+    if (!scenario.restoreFile.empty()) {
+        restore(scenario.restoreFile);
+    } else {
+        this->extractors = createExtractors(scenario.extractorTypes(), scenario.extractorFund, 0);
+        this->wholesalers = createWholesaler(nbWholesale, scenario.wholesalerFund, nbExtractor);
+        this->factories = createFactories(scenario.factoryTypes(), scenario.factoryFund, nbExtractor + nbWholesale);
 
-    for(auto i = factories.begin(); i != factories.end(); ++i) {
-        (*i)->setWholesalers(wholesalers);
+        wire(Topology::generate(scenario.topology, scenario.nbExtractors, scenario.nbFactories,
+                                scenario.nbWholesalers));
     }
 
-    int extractorsByWholesaler = nbExtractor / nbWholesale;
-    int extractorsShared = nbExtractor % nbWholesale;
+    if (scenario.executionMode != ExecutionMode::Threads) {
+        // Rempli avant que endService() ne puisse parcourir ses vendeurs
+        scheduler = std::make_unique<AgentScheduler>(scenario.nbWorkers);
+        for (Seller* agent : agents()) {
+            if (scenario.executionMode == ExecutionMode::Coroutines) {
+                scheduler->addRoutine(agent);
+            } else {
+                scheduler->add(agent);
+            }
+        }
+    }
 
-    int factoriesByWholesaler = nbFactory / nbWholesale;
-    int factoriesShared = nbFactory % nbWholesale;
+    utilsThread = std::make_unique<PcoThread>(&Utils::run, this);
+}
 
-    int countExtractor = 0;
-    int countFactory = 0;
+void Utils::wire(const Topology& topology) {
+    std::vector<Seller*> suppliers(extractors.begin(), extractors.end());
+    suppliers.insert(suppliers.end(), factories.begin(), factories.end());
 
-    for(auto& w : wholesalers) {
+    // Les adjacences sont remplies en entier avant d'en distribuer des
+    // tranches, aucune réallocation ne peut donc invalider celles-ci
+    supplierLinks.reserve(topology.nbSupplyLinks());
+    for (unsigned w = 0; w < wholesalers.size(); ++w) {
+        for (std::uint32_t s : topology.suppliersOf(w)) {
+            supplierLinks.push_back(suppliers[s]);
+        }
+    }
+    wholesalerLinks.reserve(topology.nbDemandLinks());
+    for (unsigned f = 0; f < factories.size(); ++f) {
+        for (std::uint32_t w : topology.wholesalersOf(f)) {
+            wholesalerLinks.push_back(wholesalers[w]);
+        }
+    }
 
-        std::vector<Extractor*> tmpExtractors(extractors.begin() + countExtractor, extractors.begin() + countExtractor + extractorsByWholesaler);
-        tmpExtractors.insert(tmpExtractors.end(), extractors.end() - extractorsShared, extractors.end());
+    // Un compteur par lien : les liens d'approvisionnement puis de demande
+    std::vector<TradeFlows::Link> links;
+    links.reserve(supplierLinks.size() + wholesalerLinks.size());
+    for (std::size_t i = 0, w = 0; w < wholesalers.size(); ++w) {
+        for (std::size_t end = i + topology.suppliersOf(unsigned(w)).size(); i < end; ++i) {
+            links.push_back({std::uint32_t(wholesalers[w]->getUniqueId()),
+                             std::uint32_t(supplierLinks[i]->getUniqueId())});
+        }
+    }
+    for (std::size_t i = 0, f = 0; f < factories.size(); ++f) {
+        for (std::size_t end = i + topology.wholesalersOf(unsigned(f)).size(); i < end; ++i) {
+            links.push_back({std::uint32_t(factories[f]->getUniqueId()),
+                             std::uint32_t(wholesalerLinks[i]->getUniqueId())});
+        }
+    }
+    flows.assign(std::move(links));
 
-        std::vector<Factory*> tmpFactories(factories.begin() + countFactory, factories.begin() + countFactory + factoriesByWholesaler);
-        tmpFactories.insert(tmpFactories.end(), factories.end() - factoriesShared, factories.end());
+    std::size_t first = 0;
+    for (unsigned w = 0; w < wholesalers.size(); ++w) {
+        std::size_t count = topology.suppliersOf(w).size();
+        wholesalers[w]->setSellers({supplierLinks.data() + first, count}, flows.slice(first, count));
+        first += count;
+    }
+    std::size_t flowOffset = supplierLinks.size();
+    first = 0;
+    for (unsigned f = 0; f < factories.size(); ++f) {
+        std::size_t count = topology.wholesalersOf(f).size();
+        factories[f]->setWholesalers({wholesalerLinks.data() + first, count},
+                                     flows.slice(flowOffset + first, count));
+        first += count;
+    }
+}
 
-        countExtractor += extractorsByWholesaler;
-        countFactory += factoriesByWholesaler;
+void Utils::restore(const std::string& path) {
+    CheckpointImage image;
+    std::string error;
+    if (!image.open(path, error)) {
+        qInfo() << error.c_str();
+        exit(-1);
+    }
 
-        std::vector<Seller*> sellers;
-        for (auto& m : tmpExtractors)
-            sellers.push_back(static_cast<Seller*>(m));
-        for (auto& f : tmpFactories)
-            sellers.push_back(static_cast<Seller*>(f));
-        w->setSellers(sellers);
+    const CheckpointHeader& header = image.header();
+    const std::uint32_t nbExtractor = header.nbExtractors;
+    const std::uint32_t nbWholesale = header.nbWholesalers;
+    const std::uint32_t nbFactory = header.nbFactories;
+
+    // Les fonds sont ceux du point de reprise, repris ci-dessous
+    extractors = createExtractors(scenario.extractorTypes(), 0, 0);
+    wholesalers = createWholesaler(int(nbWholesale), 0, int(nbExtractor));
+    factories = createFactories(scenario.factoryTypes(), 0, int(nbExtractor + nbWholesale));
+
+    std::vector<Seller*> sellers(extractors.begin(), extractors.end());
+    sellers.insert(sellers.end(), wholesalers.begin(), wholesalers.end());
+    sellers.insert(sellers.end(), factories.begin(), factories.end());
+    std::span<const SellerState> states = image.sellers();
+    for (std::size_t i = 0; i < sellers.size(); ++i) {
+        if (states[i].id != sellers[i]->getUniqueId()) {
+            qInfo() << "Checkpoint" << path.c_str() << "is corrupted";
+            exit(-1);
+        }
+        sellers[i]->restoreState(states[i]);
+    }
+    for (Extractor* extractor : extractors) {
+        restoredWages += extractor->getAmountPaidToMiners();
+    }
+    for (Factory* factory : factories) {
+        restoredWages += factory->getAmountPaidToWorkers();
     }
 
-    utilsThread = std::make_unique<PcoThread>(&Utils::run, this);
+    // Les liens sont enregistrés par identifiant : fournisseurs (mines puis
+    // usines) de chaque grossiste, puis grossistes de chaque usine
+    std::vector<std::vector<std::uint32_t>> suppliers(nbWholesale);
+    std::vector<std::vector<std::uint32_t>> wholesalersOf(nbFactory);
+    std::span<const LinkState> links = image.links();
+    for (std::size_t i = 0; i < links.size(); ++i) {
+        const LinkState& link = links[i];
+        bool valid;
+        if (i < header.nbSupplyLinks) {
+            std::uint32_t w = link.buyer - nbExtractor;
+            std::uint32_t s = link.seller < nbExtractor ? link.seller : link.seller - nbWholesale;
+            valid = w < nbWholesale && s < nbExtractor + nbFactory &&
+                    (link.seller < nbExtractor || link.seller >= nbExtractor + nbWholesale);
+            if (valid) {
+                suppliers[w].push_back(s);
+            }
+        } else {
+            std::uint32_t f = link.buyer - nbExtractor - nbWholesale;
+            std::uint32_t w = link.seller - nbExtractor;
+            valid = f < nbFactory && w < nbWholesale;
+            if (valid) {
+                wholesalersOf[f].push_back(w);
+            }
+        }
+        if (!valid) {
+            qInfo() << "Checkpoint" << path.c_str() << "is corrupted";
+            exit(-1);
+        }
+    }
+
+    wire(Topology::fromAdjacency(suppliers, wholesalersOf));
+
+    // wire() range les liens dans l'ordre où ils ont été écrits
+    std::span<TradeFlows::Counter> counters = flows.slice(0, flows.size());
+    for (std::size_t i = 0; i < links.size(); ++i) {
+        counters[i].units.store(links[i].units, std::memory_order_relaxed);
+    }
 }
 
-void Utils::run() {
-    for(size_t i = 0; i < extractors.size(); ++i) {
-        threads.emplace_back(std::make_unique<PcoThread>(&Extractor::run, extractors[i]));
+void Utils::saveCheckpoint(const std::string& path) {
+    std::vector<Seller*> sellers(extractors.begin(), extractors.end());
+    sellers.insert(sellers.end(), wholesalers.begin(), wholesalers.end());
+    sellers.insert(sellers.end(), factories.begin(), factories.end());
+
+    std::vector<SellerState> states(sellers.size());
+    std::vector<LinkState> links(flows.size());
+
+    // Aucun achat n'est à moitié fait pendant la copie
+    Checkpoint::quiesce();
+    for (std::size_t i = 0; i < sellers.size(); ++i) {
+        sellers[i]->saveState(states[i]);
+    }
+    for (std::size_t i = 0; i < links.size(); ++i) {
+        links[i] = {flows.link(i).buyer, flows.link(i).seller, flows.units(i)};
     }
-    for(size_t i = 0; i < factories.size(); ++i) {
-        threads.emplace_back(std::make_unique<PcoThread>(&Factory::run, factories[i]));
+    Checkpoint::resume();
+
+    CheckpointHeader header{};
+    header.nbExtractors = std::uint32_t(extractors.size());
+    header.nbWholesalers = std::uint32_t(wholesalers.size());
+    header.nbFactories = std::uint32_t(factories.size());
+    header.nbSupplyLinks = std::uint32_t(supplierLinks.size());
+    header.simulatedTime = SimClock::now();
+    header.startFund = scenario.startFund();
+
+    if (!Checkpoint::write(path, header, states, links)) {
+        qWarning() << "Could not write checkpoint" << path.c_str();
+    }
+}
+
+std::vector<Seller*> Utils::agents() const {
+    std::vector<Seller*> all(extractors.begin(), extractors.end());
+    all.insert(all.end(), factories.begin(), factories.end());
+    all.insert(all.end(), wholesalers.begin(), wholesalers.end());
+    return all;
+}
+
+void Utils::run() {
+    FundAuditor::start(scenario.auditPeriod);
+    if (!scenario.checkpointFile.empty()) {
+        Checkpoint::start(scenario.checkpointPeriod, [this] { saveCheckpoint(scenario.checkpointFile); });
     }
-    for(size_t i = 0; i < wholesalers.size(); ++i) {
-        threads.emplace_back(std::make_unique<PcoThread>(&Wholesale::run, wholesalers[i]));
+
+    if (scheduler) {
+        scheduler->start();
+        scheduler->join();
+    } else {
+        std::vector<Seller*> all = agents();
+        // Chaque routine quitte l'horloge simulée en se terminant
+        SimClock::attach(unsigned(all.size()));
+
+        for (Seller* agent : all) {
+            threads.emplace_back(std::make_unique<PcoThread>([agent] {
+                agent->run();
+                SimClock::detach();
+            }));
+        }
+
+        for (auto& thread : threads) {
+            thread->join();
+        }
     }
 
-    for (auto& thread : threads) {
-        thread->join();
+    // Dernier contrôle, une fois toutes les transactions terminées
+    FundAuditor::Totals audited = FundAuditor::stop();
+    Checkpoint::stop();
+    if (!scenario.checkpointFile.empty()) {
+        saveCheckpoint(scenario.checkpointFile);
     }
+    std::uint64_t journaled = Journal::close();
 
-    int startFund = (EXTRACTOR_FUND * int(extractors.size()) + (FACTORIES_FUND * int(factories.size()) + (WHOLESALERS_FUND * int(wholesalers.size()))));
-    int endFund = 0;
+    long long startFund = scenario.startFund();
+    long long endFund = 0;
+    long long paidToEmployees = 0;
 
     for(Extractor* extractor: extractors) {
         endFund += extractor->getFund();
-        endFund += extractor->getAmountPaidToMiners();
+        paidToEmployees += extractor->getAmountPaidToMiners();
     }
 
     for(Factory* factory: factories) {
         endFund += factory->getFund();
-        endFund += factory->getAmountPaidToWorkers();
+        paidToEmployees += factory->getAmountPaidToWorkers();
     }
+    endFund += paidToEmployees;
 
     for(Wholesale* wholesale : wholesalers) {
         endFund += wholesale->getFund();
     }
 
-    finalReport = QString("The expected fund is : %1 and you got at the end : %2").arg(startFund).arg(endFund);
+    double simulatedSeconds = double(SimClock::now()) / 1e6;
+
+    finalReport = QString("The expected fund is : %1 and you got at the end : %2\nSimulated time : %3 s")
+                      .arg(startFund).arg(endFund).arg(simulatedSeconds);
+
+    if (FundAuditor::getFirstBadEpoch() != 0) {
+        finalReport += QString("\nAudit : money %1 at epoch %2 of %3 (%4)")
+                           .arg(FundAuditor::getFirstImbalance() > 0 ? "created" : "lost")
+                           .arg(static_cast<long long>(FundAuditor::getFirstBadEpoch()))
+                           .arg(static_cast<long long>(FundAuditor::getEpoch()))
+                           .arg(static_cast<long long>(FundAuditor::getFirstImbalance()));
+    } else if (audited.wages != paidToEmployees - restoredWages) {
+        finalReport += QString("\nAudit : %1 paid to employees but %2 counted")
+                           .arg(static_cast<long long>(audited.wages))
+                           .arg(paidToEmployees - restoredWages);
+    } else {
+        finalReport += QString("\nAudit : balanced over %1 epochs")
+                           .arg(static_cast<long long>(FundAuditor::getEpoch()));
+    }
 
     qInfo() << "The expected fund is : " << startFund << " and you got at the end : " << endFund;
+    qInfo() << "Simulated time : " << simulatedSeconds << " s";
+    qInfo() << "Audit epochs : " << FundAuditor::getEpoch()
+            << ", first unbalanced : " << FundAuditor::getFirstBadEpoch();
+    if (!scenario.journalFile.empty()) {
+        qInfo() << "Journal : " << journaled << " transactions in "
+                << Journal::segmentPath(scenario.journalFile, 0).c_str() << "...";
+    }
+
+    INSTRUMENT(if (!scenario.metricsFile.empty() && !Instrumentation::dump(scenario.metricsFile)) {
+        qWarning() << "Could not write metrics to" << scenario.metricsFile.c_str();
+    })
     semEnd.release();
 }
 
@@ -181,3 +418,7 @@ QString Utils::getFinalReport()
 {
     return finalReport;
 }
+
+TradeFlows& Utils::getTradeFlows() {
+    return flows;
+}
@@ -11,41 +11,82 @@
 #include "extractor.h"
 #include "factory.h"
 #include "wholesale.h"
+#include "scenario.h"
+#include "scheduler.h"
 #include "seller.h"
+#include "simclock.h"
+#include "topology.h"
+#include "tradeflows.h"
 
-#define NB_EXTRACTOR 3
-#define NB_FACTORIES 3
-#define NB_WHOLESALER 2
-#define EXTRACTOR_FUND 200
-#define FACTORIES_FUND 300
-#define WHOLESALERS_FUND 250
+std::vector<Extractor*> createExtractors(const std::vector<ItemType>& resources, int fund, int idStart);
+std::vector<Factory*> createFactories(const std::vector<ItemType>& items, int fund, int idStart);
+std::vector<Wholesale*> createWholesaler(int nbWholesaler, int fund, int idStart);
 
-std::vector<Extractor*> createExtractors(int nbExtractors, int idStart);
-std::vector<Factory*> createFactories(int nbFactories, int idStart);
-std::vector<Wholesale*> createWholesaler(int nbWholesaler, int idStart);
+/**
+ * @brief Applique la configuration globale du scénario (mode de vente, graine,
+ *        horloge, prix, salaires et durées). À appeler avant de créer les vendeurs.
+ */
+void configureSimulation(const Scenario& scenario);
 
 class Utils {
 public:
     void externalEndService();
     QString getFinalReport();
 
+    /**
+     * @brief Unités échangées sur chaque lien du réseau
+     */
+    TradeFlows& getTradeFlows();
+
 private:
     std::vector<Extractor*> extractors;
     std::vector<Factory*> factories;
     std::vector<Wholesale*> wholesalers;
 
+    // Adjacences plates du réseau, chaque vendeur n'en garde qu'une tranche
+    std::vector<Seller*> supplierLinks;
+    std::vector<Wholesale*> wholesalerLinks;
+    // Compteurs d'échanges, dans l'ordre des liens ci-dessus
+    TradeFlows flows;
+    // Salaires versés avant le point de reprise, inconnus de FundAuditor
+    long long restoredWages = 0;
+
     std::vector<std::unique_ptr<PcoThread>> threads;
     std::unique_ptr<PcoThread> utilsThread;
+    // Utilisé à la place des threads en modes WorkStealing et Coroutines
+    std::unique_ptr<AgentScheduler> scheduler;
+
+    Scenario scenario;
 
     QString finalReport;
 
     void endService();
 
+    /**
+     * @brief Tous les vendeurs : mines, usines puis grossistes
+     */
+    std::vector<Seller*> agents() const;
+
+    /**
+     * @brief Relie les vendeurs selon la topologie
+     */
+    void wire(const Topology& topology);
+
+    /**
+     * @brief Recrée les vendeurs, leur état et le réseau d'un point de reprise
+     */
+    void restore(const std::string& path);
+
+    /**
+     * @brief Écrit un point de reprise cohérent de la simulation en cours
+     */
+    void saveCheckpoint(const std::string& path);
+
     void run();
 
     PcoSemaphore semEnd{0};
 public:
-    Utils(int nbExtractor, int nbFactory, int nbWholesale);
+    explicit Utils(const Scenario& scenario);
 
 
 };
@@ -9,103 +9,193 @@
 #include "wholesale.h"
 #include "factory.h"
 #include "costs.h"
+#include <cassert>
+#include "eventlog.h"
+#include "checkpoint.h"
+#include "fundauditor.h"
+#include "journal.h"
 #include <iostream>
-#include <pcosynchro/pcothread.h>
+#include "rng.h"
+#include "scheduler.h"
 
-WindowInterface* Wholesale::interface = nullptr;
+SimulationSink* Wholesale::interface = nullptr;
+DelayRange Wholesale::purchasePause = {100000U, 1000000U, 100000U};
 
 Wholesale::Wholesale(int uniqueId, int fund)
     : Seller(fund, uniqueId)
 {
+    INSTRUMENT(Instrumentation::add(uniqueId, "wholesaler", metrics, itemMutexes));
     interface->updateFund(uniqueId, fund);
-    interface->consoleAppendText(uniqueId, "Wholesaler Created");
+    EventLog::record(uniqueId, EventCode::WholesalerCreated);
 
 }
 
-void Wholesale::setSellers(std::vector<Seller*> sellers) {
+void Wholesale::setSellers(std::span<Seller* const> sellers, std::span<TradeFlows::Counter> flows) {
+    assert(flows.empty() || flows.size() == sellers.size());
     this->sellers = sellers;
-
-    for(Seller* seller: sellers){
-        interface->setLink(uniqueId, seller->getUniqueId());
-    }
+    this->flows = flows;
 }
 
 void Wholesale::buyResources() {
-    auto s = Seller::chooseRandomSeller(sellers);
+    assert(sellers.size());
+    std::size_t link = Rng::below(sellers.size());
+    auto s = sellers[link];
     auto m = s->getItemsForSale();
-    auto i = Seller::chooseRandomItem(m);
+    auto i = Seller::chooseRandomItem(m.items);
 
     if (i == ItemType::Nothing) {
         /* Nothing to buy... */
         return;
     }
 
-    int qty = rand() % 5 + 1;
+    int qty = Rng::between(1, 5);
     int price = qty * getCostPerUnit(i);
 
-    interface->consoleAppendText(uniqueId, QString("I would like to buy %1 of ").arg(qty) %
-                                 getItemName(i) % QString(" which would cost me %1").arg(price));
+    EventLog::record(uniqueId, EventCode::PurchaseIntent, qty, static_cast<int>(i), price);
 
-    transactionMutex.lock();
+    /* Le grossiste est seul à dépenser son argent, le contrôle reste valable
+       jusqu'au paiement sans prendre de verrou */
     if (price > money){
-        transactionMutex.unlock();
+        INSTRUMENT(metrics.fail(TradeFailure::Unaffordable));
         return;
     }
 
-    transactionMutex.unlock();
+    Checkpoint::TradeGuard guard;
+    if (!guard) {
+        /* Point de reprise en cours, l'achat attendra */
+        return;
+    }
     int bill = s->trade(i, qty); // Locking this section may cause a deadlock.
-    transactionMutex.lock();
+    receivePurchase(link, i, qty, bill);
+}
 
-    if (bill > 0) {
-        money -= bill;
-        stocks[i] += qty;
+void Wholesale::receivePurchase(std::size_t link, ItemType it, int qty, int bill) {
+    if (bill <= 0) {
+        return;
+    }
+
+    if (!flows.empty()) {
+        TradeFlows::record(flows[link], qty);
     }
-    transactionMutex.unlock();
-}
 
-void Wholesale::run() {
+    /* Argent et stock sont atomiques. Un ajout au stock ne peut pas fausser
+       la vente en cours d'un autre objet ni même du même objet : il ne fait
+       qu'augmenter la quantité contrôlée sous stockMutex(it). */
+    money -= bill;
+    FundAuditor::debit(bill);
+    stocks.add(it, qty);
+    publishStocks();
+    Journal::record(JournalKind::Trade, uniqueId, sellers[link]->getUniqueId(), it, qty, bill);
+}
 
+bool Wholesale::routineStart() {
     if (sellers.empty()) {
         std::cerr << "You have to give factories and mines to a wholeseler before launching is routine" << std::endl;
-        return;
+        return false;
+    }
+
+    EventLog::record(uniqueId, EventCode::WholesalerStarted);
+    return true;
+}
+
+std::uint64_t Wholesale::routineStep() {
+    buyResources();
+    interface->updateFund(uniqueId, money);
+    interface->updateStock(uniqueId, stocks.load());
+
+    //Temps de pause pour espacer les demandes de ressources
+    return purchasePause.draw();
+}
+
+Routine Wholesale::routine(AgentScheduler& scheduler) {
+    if (!routineStart()) {
+        co_return;
     }
 
-    interface->consoleAppendText(uniqueId, "[START] Wholesaler routine");
-    while (!PcoThread::thisThread()->stopRequested()) {
-        buyResources();
+    assert(sellers.size());
+    while (!scheduler.stopRequested()) {
+        std::size_t link = Rng::below(sellers.size());
+        auto s = sellers[link];
+        auto i = Seller::chooseRandomItem(s->getItemsForSale().items);
+
+        if (i != ItemType::Nothing) {
+            int qty = Rng::between(1, 5);
+            int price = qty * getCostPerUnit(i);
+
+            EventLog::record(uniqueId, EventCode::PurchaseIntent, qty, static_cast<int>(i), price);
+
+            // Le grossiste est seul à dépenser son argent, le contrôle reste
+            // valable pendant l'achat
+            if (price <= money) {
+                // Un point de reprise en cours reporte l'achat
+                if (Checkpoint::TradeGuard guard; guard) {
+                    int bill = 0;
+                    while (!co_await scheduler.trade(*s, i, qty, bill)) {
+                        // Vendeur occupé, retenté après les autres routines
+                    }
+                    receivePurchase(link, i, qty, bill);
+                }
+            } else {
+                INSTRUMENT(metrics.fail(TradeFailure::Unaffordable));
+            }
+        }
+
         interface->updateFund(uniqueId, money);
-        interface->updateStock(uniqueId, &stocks);
-        //Temps de pause pour espacer les demandes de ressources
+        interface->updateStock(uniqueId, stocks.load());
 
-        PcoThread::usleep((rand() % 10 + 1) * 100000);
+        //Temps de pause pour espacer les demandes de ressources
+        co_await scheduler.sleep(purchasePause.draw());
     }
-    interface->consoleAppendText(uniqueId, "[STOP] Wholesaler routine");
 
+    routineEnd();
+}
 
+void Wholesale::routineEnd() {
+    EventLog::record(uniqueId, EventCode::WholesalerStopped);
 }
 
-std::map<ItemType, int> Wholesale::getItemsForSale() {
-    return stocks;
+StockLedger Wholesale::listItemsForSale() {
+    return stocks.load();
 }
 
 int Wholesale::trade(ItemType it, int qty) {
-    transactionMutex.lock();
-
-    auto itemsForSale = getItemsForSale();
-    auto inStock = itemsForSale.find(it) != itemsForSale.end();
-    if (qty <= 0 || !inStock || stocks[it] < qty) {
-        transactionMutex.unlock();
+    if (qty <= 0 || !stocks.contains(it)) {
+        INSTRUMENT(metrics.fail(TradeFailure::Rejected));
         return 0;
     }
 
-    int cost = getCostPerUnit(it) * qty;
-    money += cost;
-    stocks[it] -= qty;
+    return sell(it, qty, getCostPerUnit(it));
+}
+
+bool Wholesale::tryTrade(ItemType it, int qty, int& bill) {
+    if (qty <= 0 || !stocks.contains(it)) {
+        INSTRUMENT(metrics.fail(TradeFailure::Rejected));
+        bill = 0;
+        return true;
+    }
 
-    transactionMutex.unlock();
-    return cost;
+    return trySell(it, qty, getCostPerUnit(it), bill);
 }
 
-void Wholesale::setInterface(WindowInterface *windowInterface) {
+void Wholesale::saveProgress(SellerState& state) {
+    state.kind = SellerKind::Wholesaler;
+    state.item = static_cast<std::uint8_t>(ItemType::Nothing);
+}
+
+void Wholesale::restoreProgress(const SellerState&) {}
+
+InstrumentedMutex& Wholesale::stockMutex(ItemType item) {
+    return itemMutexes[static_cast<std::size_t>(item)];
+}
+
+void Wholesale::setInterface(SimulationSink *windowInterface) {
     interface = windowInterface;
 }
+
+void Wholesale::setPurchasePause(DelayRange range) {
+    purchasePause = range;
+}
+
+DelayRange Wholesale::getPurchasePause() {
+    return purchasePause;
+}
@@ -1,8 +1,11 @@
 #ifndef WHOLESALE_H
 #define WHOLESALE_H
 #include "seller.h"
+#include <array>
+#include <span>
 #include <vector>
-#include "windowinterface.h"
+#include "simulationsink.h"
+#include "tradeflows.h"
 
 /**
  * @brief La classe permet l'implémentation d'un grossiste et de ces fonctions
@@ -11,15 +14,28 @@
 class Wholesale : public Seller
 {
 private:
-    // Vecteur de vendeurs (mines, usines) auxquels le grossiste peut acheter des ressources
-    std::vector<Seller*> sellers;
+    // Vendeurs (mines, usines) auxquels le grossiste peut acheter des ressources,
+    // tranche de l'adjacence possédée par Utils
+    std::span<Seller* const> sellers;
+    // Compteurs des unités achetées à chaque vendeur, parallèles à sellers
+    std::span<TradeFlows::Counter> flows;
 
-    static WindowInterface* interface;
+    // Un verrou par objet : les ventes de deux objets différents ne
+    // s'attendent pas. L'argent, atomique, n'a pas besoin de verrou.
+    std::array<InstrumentedMutex, NB_ITEM_TYPES> itemMutexes;
+
+    static SimulationSink* interface;
+    static DelayRange purchasePause;
 
     /**
      * @brief Fonction permettant d'acheter des ressources à des usines ou des mines
      */
     void buyResources();
+
+    /**
+     * @brief Ajoute au stock un achat payé bill au vendeur sellers[link]
+     */
+    void receivePurchase(std::size_t link, ItemType it, int qty, int bill);
 public:
     /**
      * @brief Constructeur de grossiste
@@ -27,21 +43,47 @@ public:
      */
     Wholesale(int uniqueId, int fund);
 
+    int trade(ItemType it, int qty) override;
+
+    bool tryTrade(ItemType it, int qty, int& bill) override;
+
     /**
-     * @brief Routine d'exécution du grossiste
+     * @brief Routine du grossiste en coroutine : attend la fin de chaque achat
+     *        sans bloquer de thread, puis fait une pause.
      */
-    void run();
-
-    std::map<ItemType, int> getItemsForSale() override;
-    int trade(ItemType it, int qty) override;
+    Routine routine(AgentScheduler& scheduler) override;
 
     /**
      * @brief Fonction permettant de lier des vendeurs
-     * @param Vecteurs
+     * @param Vendeurs, doivent rester valides pendant toute la simulation
+     * @param Compteurs d'échanges, un par vendeur ou aucun
+     */
+    void setSellers(std::span<Seller* const> sellers, std::span<TradeFlows::Counter> flows = {});
+
+    static void setInterface(SimulationSink* windowInterface);
+
+    /**
+     * @brief Durée simulée de la pause entre deux achats
+     */
+    static void setPurchasePause(DelayRange range);
+    static DelayRange getPurchasePause();
+
+protected:
+    StockLedger listItemsForSale() override;
+
+    bool routineStart() override;
+
+    /**
+     * @brief Étape de la routine d'exécution du grossiste : un achat puis une pause
      */
-    void setSellers(std::vector<Seller*> sellers);
+    std::uint64_t routineStep() override;
+
+    void routineEnd() override;
+
+    void saveProgress(SellerState& state) override;
+    void restoreProgress(const SellerState& state) override;
 
-    static void setInterface(WindowInterface* windowInterface);
+    InstrumentedMutex& stockMutex(ItemType item) override;
 };
 
 #endif // WHOLESALE_H
@@ -1,9 +1,13 @@
 #include "windowinterface.h"
 
+// Cadence de rafraîchissement des fonds et des stocks affichés
+#define UPDATE_RATE_HZ 30
+
 bool WindowInterface::sm_didInitialize = false;
 MainWindow *WindowInterface::mainwindow = nullptr;
+unsigned int WindowInterface::sm_nbEntities = 0;
 
-WindowInterface::WindowInterface() {
+WindowInterface::WindowInterface() : updates(sm_nbEntities) {
     if(!sm_didInitialize){
         std::cout << "Vous devez appeler WindowInterface::initialize()" << std::endl;
         QMessageBox::warning(nullptr,"Erreur","Vous devez appeler "
@@ -12,57 +16,40 @@ WindowInterface::WindowInterface() {
         exit(-1);
     }
 
-    if (!QObject::connect(this,
-                          SIGNAL(sig_consoleAppendText(unsigned int,QString)),
-                          mainwindow,
-                          SLOT(consoleAppendText(unsigned int, const QString&)),
-                          Qt::QueuedConnection)) {
-            std::cout << "Error with signal-slot connection" << std::endl;
-    }
-
-    if (!QObject::connect(this,
-                          SIGNAL(sig_updateFund(unsigned int, unsigned int)),
-                          mainwindow,
-                          SLOT(updateFund(unsigned int, unsigned int)),
-                          Qt::QueuedConnection)) {
-        std::cout << "Error with signal-slot connection" << std::endl;
-    }
-
-    if (!QObject::connect(this,
-                          SIGNAL(sig_updateStock(unsigned int, std::map<ItemType, int>*)),
-                          mainwindow,
-                          SLOT(updateStock(unsigned int, std::map<ItemType, int>*)),
-                          Qt::QueuedConnection)) {
-        std::cout << "Error with signal-slot connection" << std::endl;
-    }
-
-    if (!QObject::connect(this,
-                          SIGNAL(sig_set_link(int, int)),
-                          mainwindow,
-                          SLOT(set_link(int, int)),
-                          Qt::QueuedConnection)) {
-        std::cout << "Error with signal-slot connection" << std::endl;
-    }
-}
-
-void WindowInterface::consoleAppendText(unsigned int consoleId, QString text) {
-    emit sig_consoleAppendText(consoleId, text);
+    // Le minuteur vit dans le thread graphique : flushUpdates() y est appelé
+    connect(&refreshTimer, &QTimer::timeout, this, &WindowInterface::flushUpdates);
+    refreshTimer.start(1000 / UPDATE_RATE_HZ);
 }
 
 
 void WindowInterface::updateFund(unsigned int id, unsigned new_fund) {
-    emit sig_updateFund(id, new_fund);
+    updates.publishFund(id, new_fund);
 }
 
-void WindowInterface::updateStock(unsigned int id, std::map<ItemType, int>* stocks) {
-    emit sig_updateStock(id, stocks);
+void WindowInterface::updateStock(unsigned int id, const StockLedger& stocks) {
+    updates.publishStock(id, stocks);
 }
 
-void WindowInterface::setLink(int from, int to){
-    emit sig_set_link(from, to);
+void WindowInterface::flushUpdates() {
+    mainwindow->setUpdatesEnabled(false);
+    updates.drain([](const UpdateChannel::Update& update) {
+        if (update.fundChanged) {
+            mainwindow->updateFund(update.id, update.fund);
+        }
+        if (update.stockChanged) {
+            mainwindow->updateStock(update.id, update.stock);
+        }
+    });
+    // Les événements restent bruts, la console ne met en forme que les
+    // lignes affichées
+    std::vector<Event> batch;
+    events.poll([&batch](const Event& event) { batch.push_back(event); });
+    mainwindow->consoleAppendEvents(batch);
+    mainwindow->setUpdatesEnabled(true);
 }
 
-void WindowInterface::initialize(unsigned int nbExtractors, unsigned int nbFactories, unsigned int nbWholesalers) {
+void WindowInterface::initialize(const std::vector<ItemType>& extractors, const std::vector<ItemType>& factories,
+                                 unsigned int nbWholesalers) {
     if(sm_didInitialize){
         std::cout << "Vous devez ne devriez appeler WindowInterface::initialize()"
                      << " qu'une seule fois" << std::endl;
@@ -72,7 +59,8 @@ void WindowInterface::initialize(unsigned int nbExtractors, unsigned int nbFacto
                 return;
     }
 
-    mainwindow = new MainWindow(nbExtractors, nbFactories, nbWholesalers, nullptr);
+    sm_nbEntities = static_cast<unsigned int>(extractors.size() + factories.size()) + nbWholesalers;
+    mainwindow = new MainWindow(extractors, factories, nbWholesalers, nullptr);
     mainwindow->show();
     sm_didInitialize = true;
 }
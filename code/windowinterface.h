@@ -2,14 +2,18 @@
 #define WINDOWINTERFACE_H
 
 #include <QObject>
+#include <QTimer>
 #include <iostream>
 #include <QMessageBox>
+#include "eventlog.h"
 #include "mainwindow.h"
 #include "seller.h"
+#include "simulationsink.h"
+#include "updatechannel.h"
 
 class Utils;
 
-class WindowInterface : public QObject
+class WindowInterface : public QObject, public SimulationSink
 {
     Q_OBJECT
 
@@ -18,26 +22,37 @@ public:
 
     virtual ~WindowInterface(){}
 
-    static void initialize(unsigned int nbExtractors, unsigned int nbFactories, unsigned int nbWholesalers);
-
-    void consoleAppendText(unsigned int consoleId, QString text);
-
-    void updateFund(unsigned int id, unsigned new_fund);
-    void updateStock(unsigned int id, std::map<ItemType, int>* stocks);
-    void setLink(int from, int to);
+    /**
+     * @brief Crée la fenêtre principale
+     * @param extractors Ressource minée par chaque mine
+     * @param factories Objet produit par chaque usine
+     */
+    static void initialize(const std::vector<ItemType>& extractors, const std::vector<ItemType>& factories,
+                           unsigned int nbWholesalers);
+
+    /**
+     * @brief Déposent la valeur dans le canal de mise à jour, appliqué par le
+     *        thread graphique à cadence fixe (voir flushUpdates())
+     */
+    void updateFund(unsigned int id, unsigned new_fund) override;
+    void updateStock(unsigned int id, const StockLedger& stocks) override;
     void setUtils(Utils* utils);
 
+private slots:
+    /**
+     * @brief Applique en un lot les entités modifiées depuis l'image précédente
+     *        et transmet les nouveaux événements à la console
+     */
+    void flushUpdates();
+
 private:
     static bool sm_didInitialize;
     static MainWindow *mainwindow;
+    static unsigned int sm_nbEntities;
 
-
-signals:
-    void sig_consoleAppendText(unsigned int consoleId, QString text);
-
-    void sig_updateFund(unsigned int id, unsigned new_fund);
-    void sig_updateStock(unsigned int id, std::map<ItemType, int>* stocks);
-    void sig_set_link(int from, int to);
+    UpdateChannel updates;
+    EventLog::Reader events;
+    QTimer refreshTimer;
 };
 
 #endif // WINDOWINTERFACE_H